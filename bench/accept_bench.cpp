@@ -0,0 +1,113 @@
+// Measures the heap allocations and time spent accepting a connection with yonaa::acceptor, and
+// keeping it around the way that a server does. Pending connections are drained either one at a
+// time, with has_pending_connection() and accept(), or with accept_batch().
+//
+// Each connection is opened with a plain connect() from the same thread, so that only the
+// acceptor's side is counted.
+//
+// usage: accept_bench [connections] [port]
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "yonaa/acceptor.hpp"
+#include "yonaa/addresses.hpp"
+#include "yonaa/resolve.hpp"
+
+static std::atomic<size_t> allocation_count{0};
+
+void *operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+/// @brief Open count connections to the acceptor with plain connect() calls.
+static std::vector<int> connect_clients(const yonaa::endpoint &local_endpoint, size_t count) {
+    std::vector<int> client_fds;
+    for (size_t i = 0; i < count; i++) {
+        int client_fd = ::socket(local_endpoint.family(), SOCK_STREAM, 0);
+        if (::connect(client_fd, local_endpoint.data(), local_endpoint.size()) == -1) {
+            std::perror("connect");
+            std::exit(EXIT_FAILURE);
+        }
+        client_fds.push_back(client_fd);
+    }
+
+    return client_fds;
+}
+
+int main(int argc, char **argv) {
+    size_t connections = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    uint16_t port      = (argc > 2) ? (uint16_t)std::strtoul(argv[2], nullptr, 10) : 5002;
+
+    yonaa::acceptor acceptor;
+    acceptor.open(
+        yonaa::resolve(yonaa::loopback_address, std::to_string(port)),
+        yonaa::acceptor_config::reuse_address);
+    yonaa::endpoint local_endpoint = acceptor.local_endpoint();
+
+    // Connections arrive in groups, the way that they queue up between two wakeups of a server, and
+    // are kept for a while, as a server's client table would
+    const size_t group_size = 64;
+
+    for (bool is_batched : {false, true}) {
+        std::vector<yonaa::connection> accepted;
+        accepted.reserve(group_size);
+
+        size_t allocations = 0;
+        std::chrono::duration<double, std::nano> elapsed(0);
+
+        for (size_t i = 0; i < connections; i += group_size) {
+            std::vector<int> client_fds = connect_clients(local_endpoint, group_size);
+
+            size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+            auto start                = std::chrono::steady_clock::now();
+
+            if (is_batched) {
+                accepted = acceptor.accept_batch(group_size);
+            } else {
+                while (acceptor.has_pending_connection()) accepted.push_back(acceptor.accept());
+            }
+
+            elapsed += std::chrono::steady_clock::now() - start;
+            allocations += allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+            if (accepted.size() != group_size) {
+                std::fprintf(
+                    stderr, "accepted %zu of %zu connections\n", accepted.size(), group_size);
+                return EXIT_FAILURE;
+            }
+
+            accepted.clear();
+            for (int client_fd : client_fds) ::close(client_fd);
+        }
+
+        size_t accepted_count = (connections + group_size - 1) / group_size * group_size;
+        std::printf(
+            "%-14s %zu connections: %.2f allocations and %.0f ns per accept\n",
+            is_batched ? "accept_batch()" : "accept()",
+            accepted_count,
+            (double)allocations / accepted_count,
+            elapsed.count() / accepted_count);
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Measures how fast a local yonaa::server fans large messages out to a growing number of clients.
+//
+// For each client count, the server sends `messages` payloads of `payload_size` bytes to every
+// client, and the clock stops once every client has read all of them. The shared run broadcasts
+// one shared_buffer, which every client's send queue refers to. The copied run sends each client
+// its own copy of the payload with message_client(), which is what a broadcast used to cost.
+//
+// Each client is two file descriptors in this process, so large client counts may need a higher
+// `ulimit -n`.
+//
+// usage: broadcast_bench [max_clients] [messages] [payload_size] [port]
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "yonaa/addresses.hpp"
+#include "yonaa/connection.hpp"
+#include "yonaa/detail/poll.hpp"
+#include "yonaa/resolve.hpp"
+#include "yonaa/server.hpp"
+
+// Read everything sent to a set of connections, reading from whichever ones have data waiting
+static void drain(std::vector<yonaa::connection *> conns, size_t bytes_per_connection) {
+    yonaa::detail::poll_group pg(yonaa::detail::socket_status::readable);
+    std::vector<size_t> received(conns.size(), 0);
+    std::vector<size_t> index_by_fd;
+
+    for (size_t i = 0; i < conns.size(); i++) {
+        socket_type fd = conns[i]->native_socket();
+        if ((size_t)fd >= index_by_fd.size()) index_by_fd.resize(fd + 1);
+        index_by_fd[fd] = i;
+        pg.add_socket(fd);
+    }
+
+    size_t remaining = conns.size();
+    while (remaining > 0) {
+        for (const auto &event : pg.poll(-1)) {
+            size_t i = index_by_fd[event.socket_fd];
+
+            received[i] += conns[i]->receive().size();
+            if (received[i] < bytes_per_connection) continue;
+
+            pg.remove_socket(event.socket_fd);
+            remaining--;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t max_clients  = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    size_t messages     = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 16;
+    size_t payload_size = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 64 * 1024;
+    uint16_t port       = (argc > 4) ? (uint16_t)std::strtoul(argv[4], nullptr, 10) : 5002;
+
+    // Allow as many sockets as the system does
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // Hold back messages rather than dropping them, so that every run delivers every byte
+    yonaa::server_config config;
+    config.overflow_policy = yonaa::send_queue_overflow_policy::block;
+
+    std::mutex ids_mutex;
+    std::vector<yonaa::client_id> ids;
+
+    yonaa::server server(port, config);
+    server.set_client_connect_handler([&](yonaa::client_id id) {
+        std::lock_guard<std::mutex> lock(ids_mutex);
+        ids.push_back(id);
+    });
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler([](yonaa::client_id, yonaa::buffer_view) {});
+    server.run();
+
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, std::to_string(port));
+    std::vector<yonaa::connection> conns(max_clients);
+    size_t connected = 0;
+
+    yonaa::buffer payload(payload_size);
+    payload.zero();
+    size_t reader_count = std::max<size_t>(std::thread::hardware_concurrency() / 2, 1);
+
+    std::printf("%zu x %zu byte messages per client\n", messages, payload_size);
+    std::printf("%8s %16s %16s\n", "clients", "shared (MB/s)", "copied (MB/s)");
+
+    for (size_t client_count = 1; client_count <= max_clients; client_count *= 10) {
+        // Connect more clients, retrying until the server's acceptor is open
+        for (; connected < client_count; connected++) {
+            std::error_code ec;
+            do {
+                conns[connected].connect(endpoints, ec);
+                if (ec) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            } while (ec);
+        }
+        std::vector<yonaa::client_id> client_ids;
+        while (client_ids.size() != client_count) {
+            std::lock_guard<std::mutex> lock(ids_mutex);
+            client_ids = ids;
+        }
+
+        double rates[2];
+        for (int run = 0; run < 2; run++) {
+            std::vector<std::vector<yonaa::connection *>> shares(reader_count);
+            for (size_t i = 0; i < client_count; i++) {
+                shares[i % reader_count].push_back(&conns[i]);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            std::vector<std::thread> readers;
+            for (auto &share : shares) {
+                readers.emplace_back(drain, share, messages * payload_size);
+            }
+
+            if (run == 0) {
+                auto shared_payload = yonaa::make_shared_buffer(payload);
+                for (size_t i = 0; i < messages; i++) server.message_all_clients(shared_payload);
+            } else {
+                for (size_t i = 0; i < messages; i++) {
+                    for (auto id : client_ids) server.message_client(payload, id);
+                }
+            }
+
+            for (auto &reader : readers) reader.join();
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            double bytes = (double)client_count * messages * payload_size;
+            rates[run]   = bytes / elapsed.count() / 1e6;
+        }
+
+        std::printf("%8zu %16.1f %16.1f\n", client_count, rates[0], rates[1]);
+    }
+
+    for (size_t i = 0; i < connected; i++) conns[i].disconnect();
+    server.stop();
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Compares yonaa::buffer against the std::vector-backed buffer that it replaced.
+//
+// Each case runs `iterations` times, and reports the average time per iteration:
+//   - small copy:   construct a 64 byte buffer from existing data, then destroy it
+//   - large copy:   construct a 4 KiB buffer from existing data, then destroy it
+//   - receive:      size a buffer for an 8 KiB receive, write a 20 byte message into it, and shrink
+//                   it to fit (the pattern of connection::receive())
+//   - move:         move a 4 KiB buffer into a vector and back out again
+//
+// usage: buffer_bench [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "yonaa/buffer.hpp"
+
+// The storage of yonaa::buffer before it gained inline storage and uninitialized resizes
+struct vector_buffer {
+    vector_buffer() {}
+    vector_buffer(const char *data, size_t size) : data_(data, data + size) {}
+    explicit vector_buffer(size_t size) { data_.resize(size); }
+
+    char *data() { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    void resize(size_t new_size) { data_.resize(new_size); }
+
+    std::vector<char> data_;
+};
+
+// Keep the compiler from optimizing the work away
+static volatile char sink;
+
+/// @brief Read the last byte of a buffer into the sink, so that filling the buffer is not
+/// optimized away. Empty buffers have no bytes to read.
+template<typename Buffer>
+static void consume(Buffer &b) {
+    if (b.size() > 0) sink = b.data()[b.size() - 1];
+}
+
+template<typename Function>
+static double time_per_iteration(size_t iterations, Function &&function) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) function();
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+template<typename Buffer>
+static void run(const char *name, size_t iterations, void (*resize)(Buffer &, size_t)) {
+    static const std::string small_data(64, 's');
+    static const std::string large_data(4096, 'l');
+    static const char message[] = "a twenty byte message";
+
+    double small_copy = time_per_iteration(iterations, [&]() {
+        Buffer b(small_data.data(), small_data.size());
+        consume(b);
+    });
+
+    double large_copy = time_per_iteration(iterations, [&]() {
+        Buffer b(large_data.data(), large_data.size());
+        consume(b);
+    });
+
+    double receive = time_per_iteration(iterations, [&]() {
+        Buffer b;
+        resize(b, 8192);
+        std::memcpy(b.data(), message, 20);
+        resize(b, 20);
+        consume(b);
+    });
+
+    std::vector<Buffer> buffers;
+    buffers.reserve(1);
+    Buffer moving(large_data.data(), large_data.size());
+    double move = time_per_iteration(iterations, [&]() {
+        buffers.push_back(std::move(moving));
+        moving = std::move(buffers.back());
+        buffers.pop_back();
+        consume(moving);
+    });
+
+    std::printf(
+        "%-14s %12.1f %12.1f %12.1f %12.1f\n", name, small_copy, large_copy, receive, move);
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::printf("%zu iterations, ns per iteration\n", iterations);
+    std::printf(
+        "%-14s %12s %12s %12s %12s\n", "", "small copy", "large copy", "receive", "move");
+
+    run<vector_buffer>(
+        "vector", iterations, [](vector_buffer &b, size_t size) { b.resize(size); });
+    run<yonaa::buffer>("yonaa::buffer", iterations, [](yonaa::buffer &b, size_t size) {
+        b.resize_uninitialized(size);
+    });
+
+    return 0;
+}
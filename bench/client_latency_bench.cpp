@@ -0,0 +1,103 @@
+// Measures the round-trip latency of a small message sent by a yonaa::client and echoed by a local
+// yonaa::server, as seen by a thread that sleeps until the client's data receive handler wakes it.
+// Also measures the CPU time that the process uses while the client sits idle.
+//
+// usage: client_latency_bench [round_trips] [port]
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yonaa/addresses.hpp"
+#include "yonaa/client.hpp"
+#include "yonaa/server.hpp"
+
+/// @brief Return the CPU time used by every thread of this process so far, in microseconds.
+static double process_cpu_time_us() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    auto to_us = [](const timeval &tv) { return tv.tv_sec * 1e6 + tv.tv_usec; };
+    return to_us(usage.ru_utime) + to_us(usage.ru_stime);
+}
+
+int main(int argc, char **argv) {
+    size_t round_trips = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    uint16_t port      = (argc > 2) ? (uint16_t)std::strtoul(argv[2], nullptr, 10) : 5002;
+
+    // Start an echo server
+    yonaa::server server(port);
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler(
+        [&](yonaa::client_id id, yonaa::buffer_view data) { server.message_client(data, id); });
+    server.run();
+
+    // Connect a client to it, and count the bytes that it receives
+    std::mutex mutex;
+    std::condition_variable received_cv;
+    size_t bytes_received = 0;
+
+    std::promise<void> connected;
+    yonaa::client client;
+    client.set_connect_handler([&]() { connected.set_value(); });
+    client.set_disconnect_handler([]() {});
+    client.set_data_receive_handler([&](yonaa::buffer_view data) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bytes_received += data.size();
+        }
+        received_cv.notify_one();
+    });
+
+    client.connect(yonaa::loopback_address, std::to_string(port));
+    connected.get_future().wait();
+
+    yonaa::buffer message("ping-ping-ping-ping-ping-ping-pi");
+    std::vector<double> samples;
+    samples.reserve(round_trips);
+
+    for (size_t i = 1; i <= round_trips; i++) {
+        auto start = std::chrono::steady_clock::now();
+
+        client.send_message(message);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        received_cv.wait(lock, [&] { return bytes_received >= i * message.size(); });
+
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples[(size_t)(p * (samples.size() - 1))]; };
+
+    std::printf(
+        "%zu round trips: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+        samples.size(),
+        percentile(0.50),
+        percentile(0.99),
+        samples.back());
+
+    // Leave the client idle for a while
+    double cpu_before = process_cpu_time_us();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    double cpu_after = process_cpu_time_us();
+
+    std::printf("idle for 1 s: %.0f us of CPU time\n", cpu_after - cpu_before);
+
+    client.disconnect();
+    server.stop();
+
+    return 0;
+}
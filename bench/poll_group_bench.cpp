@@ -0,0 +1,183 @@
+// Compares the cost of waiting for messages with each detail::poll_group backend.
+//
+// Every iteration writes one small message to each of `batch` idle sockets (out of `sockets`
+// registered ones), waits for them with poll_group::poll(), and reads them back. Each call to
+// poll() is one system call for every backend, but poll(2) scans every registered socket in the
+// kernel and in user space, while epoll only touches the ready ones. The churn phase adds and
+// removes a socket per message, which costs two epoll_ctl() calls with epoll but no system calls
+// with poll(2).
+//
+// The system calls made per message are counted as well: the waits and registrations made by the
+// poll group (wrapped at link time, see bench/CMakeLists.txt) along with the bench's own write and
+// read.
+//
+// usage: poll_group_bench [sockets] [batch] [iterations]
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "yonaa/detail/poll.hpp"
+
+using yonaa::detail::poll_backend;
+
+// The number of system calls made since the last reset
+static size_t syscall_count = 0;
+
+// The system calls that poll_group makes, counted by wrapping them with `ld --wrap`
+extern "C" {
+int __real_poll(pollfd *fds, nfds_t nfds, int timeout);
+int __real_epoll_wait(int epfd, epoll_event *events, int maxevents, int timeout);
+int __real_epoll_ctl(int epfd, int op, int fd, epoll_event *event);
+
+int __wrap_poll(pollfd *fds, nfds_t nfds, int timeout) {
+    syscall_count++;
+    return __real_poll(fds, nfds, timeout);
+}
+
+int __wrap_epoll_wait(int epfd, epoll_event *events, int maxevents, int timeout) {
+    syscall_count++;
+    return __real_epoll_wait(epfd, events, maxevents, timeout);
+}
+
+int __wrap_epoll_ctl(int epfd, int op, int fd, epoll_event *event) {
+    syscall_count++;
+    return __real_epoll_ctl(epfd, op, fd, event);
+}
+}
+
+/// @brief Write to a socket, counting the system call.
+static void counted_write(int socket_fd, const void *data, size_t size) {
+    syscall_count++;
+    (void)!::write(socket_fd, data, size);
+}
+
+/// @brief Read from a socket, counting the system call.
+static void counted_read(int socket_fd, void *data, size_t size) {
+    syscall_count++;
+    (void)!::read(socket_fd, data, size);
+}
+
+static const char *backend_name(poll_backend backend) {
+    switch (backend) {
+        case poll_backend::poll:
+            return "poll";
+        case poll_backend::epoll:
+            return "epoll";
+    }
+
+    return "unknown";
+}
+
+static void run(poll_backend requested, size_t num_sockets, size_t batch, size_t iterations) {
+    yonaa::detail::poll_group pg(yonaa::detail::socket_status::readable, requested);
+    if (pg.backend() != requested) {
+        std::printf("%-9s unavailable\n", backend_name(requested));
+        return;
+    }
+
+    std::vector<int> local(num_sockets);
+    std::vector<int> remote(num_sockets);
+    for (size_t i = 0; i < num_sockets; i++) {
+        int pair[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == -1) {
+            std::perror("socketpair");
+            std::exit(EXIT_FAILURE);
+        }
+
+        local[i]  = pair[0];
+        remote[i] = pair[1];
+        pg.add_socket(local[i]);
+    }
+
+    char message[64] = {};
+    char scratch[64];
+
+    // Steady state --------------------------------------------------------------------------------
+    size_t waits    = 0;
+    size_t messages = 0;
+    syscall_count   = 0;
+    auto start      = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) {
+        for (size_t j = 0; j < batch; j++) {
+            counted_write(remote[(i * batch + j) % num_sockets], message, sizeof(message));
+        }
+
+        size_t pending = batch;
+        while (pending > 0) {
+            auto events = pg.poll(-1);
+            waits++;
+
+            for (const auto &[socket_fd, status] : events) {
+                counted_read(socket_fd, scratch, sizeof(scratch));
+                pending--;
+                messages++;
+            }
+        }
+    }
+
+    auto steady_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    size_t steady_syscalls = syscall_count;
+
+    // Churn ---------------------------------------------------------------------------------------
+    syscall_count = 0;
+    start         = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) {
+        int socket_fd = local[i % num_sockets];
+        pg.remove_socket(socket_fd);
+        pg.add_socket(socket_fd);
+
+        counted_write(remote[i % num_sockets], message, sizeof(message));
+        for (bool done = false; !done;) {
+            for (const auto &info : pg.poll(-1)) {
+                counted_read(info.socket_fd, scratch, sizeof(scratch));
+                done = true;
+            }
+        }
+    }
+
+    auto churn_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    size_t churn_syscalls = syscall_count;
+
+    std::printf(
+        "%-9s %8.0f ns/msg  %5.3f waits/msg  %5.3f syscalls/msg  |  churn: %8.0f ns/msg  %5.3f "
+        "syscalls/msg\n",
+        backend_name(requested),
+        (double)steady_ns / messages,
+        (double)waits / messages,
+        (double)steady_syscalls / messages,
+        (double)churn_ns / iterations,
+        (double)churn_syscalls / iterations);
+
+    for (size_t i = 0; i < num_sockets; i++) {
+        ::close(local[i]);
+        ::close(remote[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t num_sockets = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    size_t batch       = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 16;
+    size_t iterations  = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 2000;
+
+    std::printf(
+        "%zu sockets, %zu ready per wait, %zu iterations\n", num_sockets, batch, iterations);
+
+    for (auto backend : {poll_backend::poll, poll_backend::epoll}) {
+        run(backend, num_sockets, batch, iterations);
+    }
+
+    return 0;
+}
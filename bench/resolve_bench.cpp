@@ -0,0 +1,87 @@
+// Measures the heap allocations and time spent resolving numeric addresses and ports with
+// yonaa::resolve(), which builds their endpoints directly, against resolving them through
+// getaddrinfo() and packing the results the way that resolve() does for other names.
+//
+// usage: resolve_bench [iterations]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "yonaa/addresses.hpp"
+#include "yonaa/detail/getaddrinfo.hpp"
+#include "yonaa/resolve.hpp"
+
+static std::atomic<size_t> allocation_count{0};
+
+void *operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+/// @brief Resolve a name through getaddrinfo(), bypassing resolve()'s numeric fast path.
+static yonaa::resolve_result resolve_with_getaddrinfo(
+    const std::string &hostname, const std::string &service) {
+    yonaa::resolve_result result;
+
+    gai_result_type *target_info = yonaa::detail::gai::getaddrinfo(hostname, service);
+    for (gai_result_type *ai = target_info; ai != nullptr; ai = ai->ai_next) {
+        result.push_back(
+            yonaa::endpoint::from_native_address(ai->ai_protocol, ai->ai_addr, ai->ai_addrlen));
+    }
+    if (target_info) freeaddrinfo(target_info);
+
+    return result;
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    const std::string service("8080");
+    const std::vector<std::string> hostnames = {
+        "10.2.3.4", "::1", yonaa::any_address, yonaa::loopback_address};
+
+    for (const std::string &hostname : hostnames) {
+        for (bool is_fast_path : {false, true}) {
+            size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+            auto start                = std::chrono::steady_clock::now();
+
+            size_t endpoint_count = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                yonaa::resolve_result result = is_fast_path
+                                                   ? yonaa::resolve(hostname, service)
+                                                   : resolve_with_getaddrinfo(hostname, service);
+                endpoint_count += result.size();
+            }
+
+            std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+            size_t allocations = allocation_count.load(std::memory_order_relaxed) -
+                                 allocations_before;
+
+            std::printf(
+                "%-12s %-13s %zu endpoints: %.2f allocations and %.0f ns per call\n",
+                hostname.c_str(),
+                is_fast_path ? "resolve()" : "getaddrinfo()",
+                endpoint_count / iterations,
+                (double)allocations / iterations,
+                elapsed.count() / iterations);
+        }
+    }
+
+    return 0;
+}
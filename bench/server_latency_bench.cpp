@@ -0,0 +1,69 @@
+// Measures the round-trip latency of a small message echoed by a local yonaa::server.
+//
+// usage: server_latency_bench [round_trips] [port]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "yonaa/addresses.hpp"
+#include "yonaa/connection.hpp"
+#include "yonaa/resolve.hpp"
+#include "yonaa/server.hpp"
+
+int main(int argc, char **argv) {
+    size_t round_trips = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    uint16_t port      = (argc > 2) ? (uint16_t)std::strtoul(argv[2], nullptr, 10) : 5001;
+
+    // Start an echo server
+    yonaa::server server(port);
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler(
+        [&](yonaa::client_id id, yonaa::buffer_view data) { server.message_client(data, id); });
+    server.run();
+
+    // Connect to it, retrying until the server's acceptor is open
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, std::to_string(port));
+
+    yonaa::connection conn;
+    std::error_code ec;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        conn.connect(endpoints, ec);
+    } while (ec);
+
+    yonaa::buffer message("ping-ping-ping-ping-ping-ping-pi");
+    std::vector<double> samples;
+    samples.reserve(round_trips);
+
+    for (size_t i = 0; i < round_trips; i++) {
+        auto start = std::chrono::steady_clock::now();
+
+        conn.send(message);
+        size_t received = 0;
+        while (received < message.size()) { received += conn.receive().size(); }
+
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples[(size_t)(p * (samples.size() - 1))]; };
+
+    std::printf(
+        "%zu round trips: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+        samples.size(),
+        percentile(0.50),
+        percentile(0.99),
+        samples.back());
+
+    conn.disconnect();
+    server.stop();
+
+    return 0;
+}
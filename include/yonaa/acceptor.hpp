@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <system_error>
+#include <vector>
 
 #include "bitmask/bitmask.hpp"
 #include "yonaa/connection.hpp"
@@ -14,11 +16,48 @@ enum class acceptor_config {
     none          = 0x00,
     reuse_address = 0x01,  /// @brief Specifies that this acceptor should use the SO_REUSEADDR
                            /// option when configuring its socket. (see: man 7 ip)
+    reuse_port    = 0x02,  /// @brief Specifies that this acceptor should use the SO_REUSEPORT
+                           /// option when configuring its socket, so that several acceptors can
+                           /// bind the same address and have incoming connections spread across
+                           /// them by the kernel. (see: man 7 socket)
 };
-BITMASK_DEFINE_MAX_ELEMENT(acceptor_config, reuse_address)
+BITMASK_DEFINE_MAX_ELEMENT(acceptor_config, reuse_port)
 using acceptor_config_mask = bitmask::bitmask<acceptor_config>;
 
-/// @brief A networking entity that allows a host to listen for and accept incoming connections.
+/// @brief Options used to tune the listening socket of an acceptor.
+struct acceptor_options {
+    /// @brief The most connections that may wait to be accepted. Connections that arrive while the
+    /// backlog is full have to retry, which costs them a second or more. The kernel caps this at
+    /// net.core.somaxconn. (see: man 2 listen)
+    int backlog = 128;
+
+    /// @brief Use the SO_REUSEADDR option, so that the address can be bound again right after a
+    /// previous listener on it closes. (see: man 7 ip)
+    bool reuse_address = true;
+
+    /// @brief Use the SO_REUSEPORT option, so that several acceptors can bind the same address and
+    /// have incoming connections spread across them by the kernel. (see: man 7 socket)
+    bool reuse_port = false;
+
+    /// @brief If nonzero, use the TCP_DEFER_ACCEPT option, so that a connection is only reported as
+    /// pending once its first data has arrived, or once this long has passed. Saves a wakeup per
+    /// connection for protocols where the client speaks first. (see: man 7 tcp)
+    std::chrono::seconds defer_accept = std::chrono::seconds(0);
+
+    /// @brief If nonzero, use the TCP_FASTOPEN option with this many pending Fast Open requests, so
+    /// that returning clients can send data along with their SYN, saving a round trip. The kernel
+    /// must also have server support enabled in net.ipv4.tcp_fastopen. (see: man 7 tcp)
+    int fast_open_queue_length = 0;
+
+    /// @brief If not negative, use the SO_INCOMING_CPU option, so that among several acceptors that
+    /// share a port with reuse_port, this one is given the connections whose packets are processed
+    /// by this CPU. (see: man 7 socket)
+    int incoming_cpu = -1;
+};
+
+/// @brief A networking entity that allows a host to listen for and accept incoming connections. An
+/// acceptor may listen at several local addresses at once (such as the IPv4 and IPv6 addresses
+/// that any_address resolves to), with one listening socket for each.
 class acceptor {
    public:
     /// @brief Create an unopened and unbound acceptor.
@@ -37,8 +76,9 @@ class acceptor {
     // ---------------------------------------------------------------------------------------------
 
    public:
-    /// @brief Bind this acceptor to the resolved local address and open it to incoming connections.
-    /// @param local_endpoints The resolved local address.
+    /// @brief Bind this acceptor to every resolved local address that it can, and open it to
+    /// incoming connections at each of them.
+    /// @param local_endpoints The resolved local addresses.
     /// @param cfg A bitmask of acceptor_config values to customize how this acceptor is opened.
     void open(
         const resolve_result &local_endpoints, acceptor_config_mask cfg = acceptor_config::none);
@@ -52,6 +92,24 @@ class acceptor {
         std::error_code &ec,
         acceptor_config_mask cfg = acceptor_config::none);
 
+    /// @brief Bind this acceptor to every resolved local address that it can, and open it to
+    /// incoming connections at each of them. Addresses that cannot be bound are skipped; this only
+    /// fails if none can be.
+    /// @param local_endpoints The resolved local addresses.
+    /// @param options Options used to tune the listening sockets.
+    void open(const resolve_result &local_endpoints, const acceptor_options &options);
+
+    /// @brief Bind this acceptor to every resolved local address that it can, and open it to
+    /// incoming connections at each of them. Addresses that cannot be bound are skipped; this only
+    /// fails if none can be.
+    /// @param local_endpoints The resolved local addresses.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param options Options used to tune the listening sockets.
+    void open(
+        const resolve_result &local_endpoints,
+        std::error_code &ec,
+        const acceptor_options &options);
+
     /// @brief Stop this acceptor from accepting incoming connections and close it.
     void close();
 
@@ -63,23 +121,71 @@ class acceptor {
     /// @return True if this acceptor has a connection waiting to be accepted.
     bool has_pending_connection() const;
 
-    /// @brief Return a connection to the remote attempting to connect to this acceptor.
+    /// @brief Return a connection to the remote attempting to connect to this acceptor, waiting for
+    /// one at every local address that this acceptor is bound to.
     /// @return A connection to the remote attempting to connect to this acceptor.
     connection accept() const;
 
-    /// @brief Return a connection to the remote attempting to connect to this acceptor.
+    /// @brief Return a connection to the remote attempting to connect to this acceptor, waiting for
+    /// one at every local address that this acceptor is bound to.
     /// @return A connection to the remote attempting to connect to this acceptor.
     /// @param ec An error_code that is set if an error occurs.
     connection accept(std::error_code &ec) const;
 
-    /// @brief Return the local endpoint that this acceptor is bound to. Invalid if this acceptor is
-    /// not bound.
-    /// @return The local endpoint that this acceptor is bound to.
+    /// @brief Accept up to max_connections pending connections without blocking, with one system
+    /// call per connection. Every listening socket is drained, starting from a different one on
+    /// each call so that none of them is starved. The first call puts this acceptor in non-blocking
+    /// mode, so accept() fails rather than waiting if no connection is pending afterwards. The
+    /// accepted connections are in non-blocking mode, and are not inherited by child processes.
+    /// @param max_connections The most connections to be accepted.
+    /// @return The connections accepted, in the order that they arrived. Empty if no connections
+    /// were pending. If an error occurs after some connections were accepted, they are returned
+    /// rather than thrown away, and the error is only thrown once a call accepts nothing.
+    std::vector<connection> accept_batch(size_t max_connections);
+
+    /// @brief Accept up to max_connections pending connections without blocking, with one system
+    /// call per connection. Every listening socket is drained, starting from a different one on
+    /// each call so that none of them is starved. The first call puts this acceptor in non-blocking
+    /// mode, so accept() fails rather than waiting if no connection is pending afterwards. The
+    /// accepted connections are in non-blocking mode, and are not inherited by child processes.
+    /// @param max_connections The most connections to be accepted.
+    /// @param ec An error_code that is set if an error occurs. The connections accepted before the
+    /// error are still returned.
+    /// @return The connections accepted, in the order that they arrived. Empty if no connections
+    /// were pending.
+    std::vector<connection> accept_batch(size_t max_connections, std::error_code &ec);
+
+    /// @brief Return the first native socket associated with this acceptor, or 0 if this acceptor
+    /// is not open.
+    /// @return The first native socket associated with this acceptor.
+    socket_type native_socket() const;
+
+    /// @brief Return every native socket associated with this acceptor, one for each local endpoint
+    /// that it is bound to.
+    /// @return Every native socket associated with this acceptor.
+    const std::vector<socket_type> &native_sockets() const;
+
+    /// @brief Return the first local endpoint that this acceptor is bound to. Invalid if this
+    /// acceptor is not bound.
+    /// @return The first local endpoint that this acceptor is bound to.
     endpoint local_endpoint() const;
 
+    /// @brief Return every local endpoint that this acceptor is bound to, in the same order as
+    /// native_sockets().
+    /// @return Every local endpoint that this acceptor is bound to.
+    const std::vector<endpoint> &local_endpoints() const;
+
    private:
-    socket_type socket_;
-    endpoint local_endpoint_;
+    void accept_pending_(
+        size_t socket_index,
+        size_t max_connections,
+        std::vector<connection> &connections,
+        std::error_code &ec);
+
+    std::vector<socket_type> sockets_;
+    std::vector<endpoint> local_endpoints_;
+    size_t next_socket_index_ = 0;  // The socket that the next accept_batch() drains first
+    bool is_non_blocking_     = false;
 };
 
 }  // namespace yonaa
@@ -5,11 +5,16 @@
 namespace yonaa {
 
 /// @brief The hostname used to refer to the host computer in calls to net::resolve() to produce a
-/// socket bindable to all local interfaces. (see: INADDR_ANY).
+/// socket bindable to all local interfaces. Resolves to the unspecified address of each family
+/// that the host has configured. (see: INADDR_ANY, in6addr_any)
 const std::string any_address = "0.0.0.0";
 
 /// @brief The hostname used to refer to the host computer in calls to net::resolve() to connect
 /// to a local socket.
 const std::string loopback_address = "127.0.0.1";
 
+/// @brief The hostname used to refer to the host computer in calls to net::resolve() to connect
+/// to a local socket over IPv6.
+const std::string loopback_address_v6 = "::1";
+
 }  // namespace yonaa
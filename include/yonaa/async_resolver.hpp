@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "yonaa/resolve.hpp"
+#include "yonaa/resolver_cache.hpp"
+
+namespace yonaa {
+
+/// @brief Identifies a request made to an async_resolver, so that it can be canceled.
+using resolve_request_id = uint64_t;
+
+/// @brief Options used to customize the behavior of an async_resolver.
+struct async_resolver_config {
+    /// @brief The number of threads that resolve names. Each thread blocks for as long as a single
+    /// resolution takes, so this is the most names that are resolved at once.
+    size_t thread_count = 4;
+
+    /// @brief The most requests that may be unfinished at once. Requests made while this many are
+    /// unfinished fail right away with std::errc::resource_unavailable_try_again, rather than
+    /// blocking the caller.
+    size_t max_pending_requests = 256;
+
+    /// @brief The timeout used for requests that do not specify one. Zero means no timeout.
+    std::chrono::milliseconds default_timeout = std::chrono::seconds(10);
+
+    /// @brief If set, the cache that results are looked up in and stored to.
+    std::shared_ptr<resolver_cache> cache;
+};
+
+/// @brief Resolves names on a small pool of threads of its own, so that callers (such as network
+/// threads) never block on a slow lookup.
+class async_resolver {
+   public:
+    /// @brief The signature for a callback function called with the result of a request. The
+    /// error_code is std::errc::timed_out if the request timed out, and
+    /// std::errc::operation_canceled if it was canceled.
+    using resolve_handler = std::function<void(resolve_result, std::error_code)>;
+
+    /// @brief The signature for a function that runs a task on the thread that should receive a
+    /// result, such as one that posts the task to the caller's network thread.
+    using executor = std::function<void(std::function<void()>)>;
+
+   public:
+    /// @brief Create an async resolver and start its threads.
+    /// @param config Options used to customize the behavior of this resolver.
+    explicit async_resolver(const async_resolver_config &config = async_resolver_config());
+
+    /// @brief Cancel every unfinished request, and then stop the threads of this resolver. Waits
+    /// for any resolutions already in progress to return.
+    ~async_resolver();
+
+    // Disable copies and moves --------------------------------------------------------------------
+
+    async_resolver(const async_resolver &other)             = delete;
+    async_resolver &operator=(const async_resolver &other)  = delete;
+    async_resolver(const async_resolver &&other)            = delete;
+    async_resolver &operator=(const async_resolver &&other) = delete;
+
+    // ---------------------------------------------------------------------------------------------
+
+    /// @brief Start resolving the given hostname and service without blocking. The handler is
+    /// called exactly once: with the result, or with an error if the request fails, times out or
+    /// is canceled.
+    /// @param hostname The IP (v4 or v6) address of the desired host, or their canonical name.
+    /// @param service The name of the desired service or its corresponding port number, in string
+    /// form.
+    /// @param handler The function to be called with the result.
+    /// @return An identifier for the request, to be passed to cancel().
+    resolve_request_id async_resolve(
+        const std::string &hostname, const std::string &service, resolve_handler handler);
+
+    /// @brief Start resolving the given hostname and service without blocking. The handler is
+    /// called exactly once: with the result, or with an error if the request fails, times out or
+    /// is canceled.
+    /// @param hostname The IP (v4 or v6) address of the desired host, or their canonical name.
+    /// @param service The name of the desired service or its corresponding port number, in string
+    /// form.
+    /// @param handler The function to be called with the result.
+    /// @param timeout The longest to wait for the result. Zero means no timeout.
+    /// @param handler_executor If set, the handler is called through this function rather than on
+    /// one of this resolver's threads.
+    /// @return An identifier for the request, to be passed to cancel().
+    resolve_request_id async_resolve(
+        const std::string &hostname,
+        const std::string &service,
+        resolve_handler handler,
+        std::chrono::milliseconds timeout,
+        executor handler_executor = executor());
+
+    /// @brief Cancel an unfinished request, whose handler is then called with
+    /// std::errc::operation_canceled. A resolution that is already in progress still runs to
+    /// completion, but its result is discarded.
+    /// @param id The request to be canceled.
+    /// @return True if the request was canceled, and false if it had already finished.
+    bool cancel(resolve_request_id id);
+
+    /// @brief Return the number of requests that have not finished yet.
+    /// @return The number of requests that have not finished yet.
+    size_t pending_requests() const;
+
+   private:
+    using clock_type = std::chrono::steady_clock;
+
+    struct request {
+        std::string hostname;
+        std::string service;
+        resolve_handler handler;
+        executor handler_executor;
+        clock_type::time_point deadline;
+        bool has_deadline = false;
+    };
+
+    void worker_function_();
+    void timer_function_();
+    static void complete_(request &&r, resolve_result result, std::error_code ec);
+
+   private:
+    async_resolver_config config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable deadlines_changed_;
+    std::map<resolve_request_id, request> requests_;  // Unfinished requests
+    std::deque<resolve_request_id> queue_;            // Requests that no thread has started yet
+    resolve_request_id next_id_ = 1;
+    bool stopping_              = false;
+
+    std::vector<std::thread> threads_;
+    std::thread timer_thread_;
+};
+
+}  // namespace yonaa
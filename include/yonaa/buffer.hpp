@@ -1,24 +1,119 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <initializer_list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "yonaa/buffer_pool.hpp"
+
 namespace yonaa {
 
+struct buffer;
+
+/// @brief A non-owning reference to data held somewhere else. (e.g. in a buffer, a std::string,
+/// or an array) Views are cheap to copy, and must not outlive the data that they refer to.
+struct buffer_view {
+    /// @brief Create an empty view.
+    buffer_view() {}
+
+    /// @brief Create a view of existing data.
+    /// @param data The data to be referred to by the view.
+    /// @param size The number of bytes to be referred to by the view.
+    buffer_view(const char *data, size_t size) : data_(data), size_(size) {}
+
+    /// @brief Create a view of the data contained by a buffer.
+    /// @param data The buffer with the data to be referred to by the view.
+    buffer_view(const buffer &data);
+
+    /// @brief Create a view of the data contained by a std::string.
+    /// @param data The std::string with the data to be referred to by the view.
+    buffer_view(const std::string &data) : buffer_view(data.data(), data.size()) {}
+
+    /// @brief Create a view of the data referred to by a std::string_view.
+    /// @param data The std::string_view that refers to the data to be referred to by the view.
+    buffer_view(std::string_view data) : buffer_view(data.data(), data.size()) {}
+
+    /// @brief Create a view of an existing POD array. As with buffer, the last element of the array
+    /// is taken to be a terminator, and is left out of the view.
+    /// @tparam T The type of the elements in the POD array.
+    /// @tparam N The number of elements in the POD array.
+    /// @param data The POD array to be referred to by the view.
+    template<typename T, size_t N>
+    buffer_view(const T (&data)[N]) : buffer_view((const char *)data, sizeof(T) * (N - 1)) {}
+
+   public:
+    /// @brief Return the data referred to by this view.
+    /// @return The data referred to by this view.
+    const char *data() const { return data_; }
+
+    /// @brief Return the number of bytes referred to by this view.
+    /// @return The number of bytes referred to by this view.
+    size_t size() const { return size_; }
+
+    /// @brief Return true if this view doesn't refer to any data.
+    /// @return True if this view doesn't refer to any data.
+    bool empty() const { return size() == 0; }
+
+    /// @brief Return true if this view refers to any data, and false otherwise.
+    operator bool() const { return size() > 0; }
+
+    /// @brief Return the data referred to by this view interpreted as the type specified by T.
+    /// @tparam T The type to interpret the data as.
+    /// @return The data referred to by this view interpreted as the type specified by T.
+    template<typename T>
+    const T *as() const {
+        return (const T *)data();
+    }
+
+    /// @brief Return a copy of the data referred to by this view in string form.
+    /// @return A copy of the data referred to by this view in string form.
+    std::string str() const { return std::string(data(), size()); }
+
+   private:
+    const char *data_ = nullptr;
+    size_t size_      = 0;
+};
+
+/// @brief Return true if two views refer to the same data, byte for byte.
+/// @param lhs The first view in this comparison.
+/// @param rhs The second view in this comparison.
+/// @return True if two views refer to the same data, byte for byte.
+inline bool operator==(buffer_view lhs, buffer_view rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    if (lhs.size() == 0) return true;
+
+    return std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
 /// @brief A utility used to wrap normal buffer operations for convenience.
+///
+/// Buffers of up to inline_capacity bytes are stored inside the buffer itself, and larger ones are
+/// drawn from the buffer pool. (see: buffer_pool.hpp)
 struct buffer {
+    /// @brief The number of bytes that a buffer can hold without allocating.
+    static constexpr size_t inline_capacity = 128;
+
     /// @brief Create an empty buffer.
     buffer() {}
 
     /// @brief Create a buffer using existing data.
     /// @param data The data to be contained by the buffer.
     /// @param size The number of bytes to be contained by the buffer.
-    buffer(const char *data, size_t size) : data_(data, data + size) {}
+    buffer(const char *data, size_t size) {
+        resize_uninitialized(size);
+        if (size > 0) std::memcpy(data_, data, size);
+    }
 
-    /// @brief Create a buffer of a specific size with no meaningful data.
+    /// @brief Create a buffer of a specific size with no meaningful data. The bytes are zeroed; use
+    /// resize_uninitialized() on an empty buffer to skip that.
     /// @param size The number of bytes to be contained by the buffer.
-    explicit buffer(size_t size) { data_.resize(size); }
+    explicit buffer(size_t size) { resize(size); }
 
     /// @brief Create a buffer from an existing POD array.
     /// @tparam T The type of the elements in the POD array.
@@ -31,18 +126,64 @@ struct buffer {
     /// @param data The std::string with the data to be contained by the buffer.
     explicit buffer(const std::string &data) : buffer(data.data(), data.size()) {}
 
+    /// @brief Create a buffer holding a copy of the data referred to by a view.
+    /// @param data The view that refers to the data to be contained by the buffer.
+    explicit buffer(buffer_view data) : buffer(data.data(), data.size()) {}
+
+    /// @brief Release the storage held by a buffer.
+    ~buffer() { release_(); }
+
+    /// @brief Copy a buffer from another buffer.
+    /// @param other The other buffer.
+    buffer(const buffer &other) : buffer(other.data(), other.size()) {}
+
+    /// @brief Move a buffer from another buffer, which is left empty. Heap storage changes hands
+    /// without being copied.
+    /// @param other The other buffer.
+    buffer(buffer &&other) noexcept { take_(other); }
+
+    /// @brief Copy a buffer from another buffer.
+    /// @param other The other buffer.
+    buffer &operator=(const buffer &other) {
+        if (this == &other) return *this;
+
+        if (other.size() > capacity_) {
+            size_ = 0;
+            grow_(other.size());
+        }
+
+        size_ = other.size();
+        if (size_ > 0) std::memcpy(data_, other.data(), size_);
+        return *this;
+    }
+
+    /// @brief Move a buffer from another buffer, which is left empty. Heap storage changes hands
+    /// without being copied.
+    /// @param other The other buffer.
+    buffer &operator=(buffer &&other) noexcept {
+        if (this == &other) return *this;
+
+        release_();
+        take_(other);
+        return *this;
+    }
+
    public:
     /// @brief Return the data contained by this buffer.
     /// @return The data contained by this buffer.
-    char *data() { return data_.data(); }
+    char *data() { return data_; }
 
     /// @brief Return the data contained by this buffer.
     /// @return The data contained by this buffer.
-    const char *data() const { return data_.data(); }
+    const char *data() const { return data_; }
 
     /// @brief Return the number of bytes contained by this buffer.
     /// @return The number of bytes contained by this buffer.
-    size_t size() const { return data_.size(); }
+    size_t size() const { return size_; }
+
+    /// @brief Return the number of bytes that this buffer can contain without allocating.
+    /// @return The number of bytes that this buffer can contain without allocating.
+    size_t capacity() const { return capacity_; }
 
     /// @brief Return true if this buffer doesn't contain any data.
     /// @return True if this buffer doesn't contain any data.
@@ -54,10 +195,28 @@ struct buffer {
     /// @brief Return true if this buffer contains any data, and false otherwise.
     operator bool() const { return size() > 0; }
 
-    /// @brief Resize the storage for the data contained by this buffer.
+    /// @brief Resize the storage for the data contained by this buffer. Any bytes added are zeroed.
     /// @param new_size The new size of the storage for the data contained by this buffer.
     void resize(size_t new_size) {
-        data_.resize(new_size);
+        size_t old_size = size_;
+        resize_uninitialized(new_size);
+
+        if (new_size > old_size) std::memset(data_ + old_size, 0, new_size - old_size);
+    }
+
+    /// @brief Resize the storage for the data contained by this buffer, leaving any bytes added
+    /// uninitialized. Useful when the bytes are about to be overwritten, as with a receive.
+    /// @param new_size The new size of the storage for the data contained by this buffer.
+    void resize_uninitialized(size_t new_size) {
+        if (new_size > capacity_) grow_(std::max(new_size, capacity_ * 2));
+        size_ = new_size;
+    }
+
+    /// @brief Make sure that this buffer can contain at least the specified number of bytes
+    /// without allocating.
+    /// @param new_capacity The number of bytes that this buffer should be able to contain.
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity_) grow_(new_capacity);
     }
 
     /// @brief Return the data contained by this buffer interpreted as the type specified by T.
@@ -84,14 +243,130 @@ struct buffer {
     /// @param other The other buffer in this comparison.
     /// @return True if this buffer contains the same data as the other buffer.
     bool operator==(const buffer &other) const {
-        if (size() != other.size()) return false;
+        return buffer_view(*this) == buffer_view(other);
+    }
+
+   private:
+    /// @brief Move the data contained by this buffer into storage for at least new_capacity bytes.
+    void grow_(size_t new_capacity) {
+        char *new_data = (char *)detail::allocate_pooled(new_capacity);
+        if (size_ > 0) std::memcpy(new_data, data_, size_);
+
+        size_t size = size_;
+        release_();
+
+        data_     = new_data;
+        size_     = size;
+        capacity_ = new_capacity;
+    }
+
+    /// @brief Return any heap storage to the buffer pool, leaving this buffer empty.
+    void release_() {
+        if (data_ != inline_data_) detail::deallocate_pooled(data_, capacity_);
 
-        return std::memcmp(data(), other.data(), size());
+        data_     = inline_data_;
+        size_     = 0;
+        capacity_ = inline_capacity;
+    }
+
+    /// @brief Take the data contained by another buffer, leaving it empty. This buffer must not
+    /// hold any heap storage.
+    void take_(buffer &other) {
+        if (other.data_ == other.inline_data_) {
+            if (other.size_ > 0) std::memcpy(inline_data_, other.inline_data_, other.size_);
+            data_     = inline_data_;
+            capacity_ = inline_capacity;
+        } else {
+            data_     = other.data_;
+            capacity_ = other.capacity_;
+        }
+        size_ = other.size_;
+
+        other.data_     = other.inline_data_;
+        other.size_     = 0;
+        other.capacity_ = inline_capacity;
     }
 
    private:
-    /// @brief The underlying storage for this buffer.
-    std::vector<char> data_;
+    /// @brief The data contained by this buffer, which points either at inline_data_ or at storage
+    /// drawn from the buffer pool.
+    char *data_      = inline_data_;
+    size_t size_     = 0;
+    size_t capacity_ = inline_capacity;
+
+    /// @brief The storage for small buffers.
+    alignas(std::max_align_t) char inline_data_[inline_capacity];
 };
 
+inline buffer_view::buffer_view(const buffer &data) : buffer_view(data.data(), data.size()) {}
+
+/// @brief A non-owning sequence of views, used to hand data held in several places to a function
+/// as a single message. A sequence refers to the container that it was created from, so it is
+/// meant to be used as a function parameter, rather than stored.
+class buffer_sequence {
+   public:
+    /// @brief Create an empty sequence.
+    buffer_sequence() {}
+
+    /// @brief Create a sequence that refers to the data contained by several buffers, in order.
+    /// @param buffers The buffers with the data to be referred to by the sequence.
+    buffer_sequence(const std::vector<buffer> &buffers)
+        : buffers_(buffers.data()), size_(buffers.size()) {}
+
+    /// @brief Create a sequence from several views, in order.
+    /// @param views The views to be contained by the sequence.
+    buffer_sequence(const std::vector<buffer_view> &views)
+        : views_(views.data()), size_(views.size()) {}
+
+    /// @brief Create a sequence from several views, in order. (e.g. {header, body}) The views live
+    /// until the end of the full expression that the list appears in, such as a function call.
+    /// @param views The views to be contained by the sequence.
+    buffer_sequence(std::initializer_list<buffer_view> views) {
+        views_ = views.begin();
+        size_  = views.size();
+    }
+
+   public:
+    /// @brief Return the number of views in this sequence.
+    /// @return The number of views in this sequence.
+    size_t size() const { return size_; }
+
+    /// @brief Return true if this sequence doesn't contain any views.
+    /// @return True if this sequence doesn't contain any views.
+    bool empty() const { return size() == 0; }
+
+    /// @brief Return the view at the specified position in this sequence.
+    /// @param index The position of the view.
+    /// @return The view at the specified position in this sequence.
+    buffer_view operator[](size_t index) const {
+        return buffers_ ? buffer_view(buffers_[index]) : views_[index];
+    }
+
+    /// @brief Return the number of bytes referred to by every view in this sequence.
+    /// @return The number of bytes referred to by every view in this sequence.
+    size_t total_size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < size(); i++) total += (*this)[i].size();
+
+        return total;
+    }
+
+   private:
+    // Note: Only one of these is set, depending on what the sequence was created from.
+    const buffer *buffers_    = nullptr;
+    const buffer_view *views_ = nullptr;
+    size_t size_              = 0;
+};
+
+/// @brief An immutable buffer that can be shared, rather than copied, between everyone who needs
+/// its data. (e.g. the send queues of every client that a message is broadcast to)
+using shared_buffer = std::shared_ptr<const buffer>;
+
+/// @brief Create a shared buffer that holds the specified data.
+/// @param data The data to be held by the shared buffer.
+/// @return A shared buffer that holds the specified data.
+inline shared_buffer make_shared_buffer(buffer data) {
+    return std::make_shared<const buffer>(std::move(data));
+}
+
 }  // namespace yonaa
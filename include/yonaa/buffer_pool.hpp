@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yonaa {
+
+/// @brief A snapshot of the activity of the pool that buffers draw their storage from.
+///
+/// Buffer storage is rounded up to one of a few size classes (64 bytes to 64 KiB, in powers of
+/// two). Released storage is kept in a small cache owned by the releasing thread, so that the next
+/// buffer of the same size class on that thread is served without taking any locks. Caches that
+/// fill up spill into a store shared by every thread, which threads with empty caches refill from.
+/// Storage larger than the largest size class always comes from the system allocator.
+struct buffer_pool_stats {
+    /// @brief The number of allocations served with storage that the pool held.
+    uint64_t hits = 0;
+
+    /// @brief The number of allocations that had to go to the system allocator.
+    uint64_t misses = 0;
+
+    /// @brief The number of bytes of free storage held by the pool, across every thread.
+    size_t bytes_held = 0;
+
+    /// @brief The most bytes of free storage that the pool's shared store may hold. (see:
+    /// set_buffer_pool_limit())
+    size_t max_bytes_held = 0;
+};
+
+/// @brief Return a snapshot of the activity of the pool that buffers draw their storage from.
+/// @return A snapshot of the activity of the pool that buffers draw their storage from.
+buffer_pool_stats get_buffer_pool_stats();
+
+/// @brief Set the most bytes of free storage that the pool's shared store may hold. Storage that
+/// is released while the store is full is returned to the system allocator. Each thread also
+/// caches up to 64 KiB of storage per size class on top of this. Lowering the limit does not
+/// release storage that is already held. (see: trim_buffer_pool())
+/// @param max_bytes_held The most bytes of free storage that the shared store may hold.
+void set_buffer_pool_limit(size_t max_bytes_held);
+
+/// @brief Return the storage held in the pool's shared store, and in the calling thread's cache,
+/// to the system allocator.
+void trim_buffer_pool();
+
+namespace detail {
+
+/// @brief Return storage for at least size bytes from the buffer pool.
+/// @param size The number of bytes needed.
+/// @return Storage for at least size bytes.
+void *allocate_pooled(size_t size);
+
+/// @brief Return storage to the buffer pool.
+/// @param storage The storage to be returned, which must have come from allocate_pooled().
+/// @param size The number of bytes that the storage was allocated for.
+void deallocate_pooled(void *storage, size_t size) noexcept;
+
+}  // namespace detail
+
+}  // namespace yonaa
@@ -1,17 +1,25 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <system_error>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "yonaa/buffer.hpp"
 #include "yonaa/connection.hpp"
+#include "yonaa/detail/wakeup.hpp"
 
 namespace yonaa {
 
+/// @brief A connection to a server that is run by a network thread of its own. The handlers are
+/// called on the network thread, and every other member function may be called from any thread.
+/// The connection itself is only ever used by the network thread.
 class client final {
    public:
-    using data_receive_handler = std::function<void(const buffer &)>;
+    using data_receive_handler = std::function<void(buffer_view)>;
     using connect_handler      = std::function<void()>;
     using disconnect_handler   = std::function<void()>;
 
@@ -19,7 +27,7 @@ class client final {
     /// @brief Create a client.
     client() = default;
 
-    /// @brief Disconnect this client.
+    /// @brief Disconnect this client, and wait for its network thread to stop.
     ~client();
 
     // Disable copies and moves --------------------------------------------------------------------
@@ -31,30 +39,64 @@ class client final {
 
     // ---------------------------------------------------------------------------------------------
 
-    /// @brief Install a function for this client to call when it receives data from the server.
+    /// @brief Install a function for this client to call when it connects to a server.
     /// @param handler The function to be called.
     void set_connect_handler(const connect_handler &handler);
 
-    /// @brief Install a function for this client to call when it connects to a server.
+    /// @brief Install a function for this client to call when it disconnects from a server.
     /// @param handler The function to be called.
     void set_disconnect_handler(const disconnect_handler &handler);
 
-    /// @brief Install a function for this client to call when it disconnects from a server.
+    /// @brief Install a function for this client to call when it receives data from the server.
+    /// The view passed to the function is only valid until it returns, so the function should copy
+    /// any data that it needs to keep.
     /// @param handler The function to be called.
     void set_data_receive_handler(const data_receive_handler &handler);
 
+    /// @brief Install a function that takes its data as a const buffer &, as data receive handlers
+    /// did before they were given views. Every message is copied into a buffer before the function
+    /// is called, so handlers that don't keep the data should take a buffer_view instead.
+    /// @tparam Handler The type of the function, which must be callable with a const buffer &, but
+    /// not with a buffer_view.
+    /// @param handler The function to be called.
+    template<
+        typename Handler,
+        std::enable_if_t<
+            std::is_invocable_v<Handler &, const buffer &> &&
+                !std::is_invocable_v<Handler &, buffer_view>,
+            int> = 0>
+    void set_data_receive_handler(Handler handler) {
+        set_data_receive_handler(data_receive_handler(
+            [handler](buffer_view data) mutable { handler(buffer(data)); }));
+    }
+
+    /// @brief Set the options to be set on this client's socket once it connects. Must be called
+    /// before connect().
+    /// @param options The options to be set.
+    void set_connection_options(const connection_options &options);
+
     /// @brief Starts theh client's network thread, in which a connection to the supplied hostname
-    /// and service pair is initiated and monitored.
+    /// and service pair is initiated and monitored. The thread sleeps until data arrives or it is
+    /// woken up, so an idle client uses no CPU time.
     /// @param hostname The name of the host to connect to.
     /// @param service The service on which to connect to the host.
     void connect(const std::string &hostname, const std::string &service);
 
-    /// @brief Request the the client disconnect from the server and stop its network thread.
+    /// @brief Request the the client disconnect from the server and stop its network thread. Safe
+    /// to call from any thread, including the handlers.
     void disconnect();
 
-    /// @brief Send data to the server.
+    /// @brief Send data to the server. When called from one of the handlers, the data is sent right
+    /// away. Otherwise it is copied and handed to the network thread, which sends it as soon as it
+    /// wakes up (and once it has connected). If the send fails, the client disconnects.
     /// @param msg The data to be sent.
-    void send_message(const buffer &msg);
+    void send_message(buffer_view msg);
+
+    /// @brief Send data held in several places to the server, as one message. (see:
+    /// send_message(buffer_view)) When called from one of the handlers, the data is sent without
+    /// joining it together first.
+    /// @param msg The data to be sent, in order.
+    void send_message(buffer_sequence msg);
 
     /// @brief Return false if the network thread is joined (or attempting to), and true otherwise.
     /// @return False if the network thread is joined (or attempting to), and true otherwise.
@@ -66,11 +108,12 @@ class client final {
 
    private:
     void network_thread_function_();
-    void handle_incoming_messages_();
+    bool handle_incoming_messages_();
+    bool send_pending_messages_();
 
    private:
-    bool running_;
-    std::error_code ec_;
+    std::atomic<bool> running_{false};
+    std::error_code ec_;  // Only used by the network thread
 
     data_receive_handler on_data_receive_;
     connect_handler on_connect_;
@@ -79,7 +122,15 @@ class client final {
     // TODO(Caleb): Add an error handling callback function
 
     std::thread network_thread_;
-    connection conn_;
+    std::atomic<std::thread::id> network_thread_id_;
+    detail::wakeup_event wakeup_;  // Interrupts the network thread's wait for data
+    connection conn_;              // Only used by the network thread
+    std::atomic<bool> is_connected_{false};
+    connection_options connection_options_;
+    buffer receive_buffer_;  // Reused for every receive, so that receiving does not allocate
+
+    std::mutex pending_sends_mutex_;
+    std::vector<buffer> pending_sends_;  // Waiting for the network thread to send them
 
     struct {
         std::string hostname;
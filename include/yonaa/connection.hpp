@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
 #include <system_error>
+#include <vector>
 
 #include "bitmask/bitmask.hpp"
 #include "yonaa/buffer.hpp"
@@ -29,6 +34,77 @@ enum class receive_flags {
 BITMASK_DEFINE_MAX_ELEMENT(receive_flags, peek)
 using receive_flags_mask = bitmask::bitmask<receive_flags>;
 
+/// @brief Options used to tune the socket of a connection. Options that are left unset are not
+/// changed, so the socket keeps whatever value it has for them (initially the system's default).
+/// When read back from a connection, every field is set to the value in effect, so the options
+/// read from one connection can be set on another unchanged.
+struct connection_options {
+    /// @brief Whether to use the TCP_NODELAY option, so that small writes are sent right away
+    /// rather than held back (by Nagle's algorithm) until earlier data is acknowledged. (see: man 7
+    /// tcp)
+    std::optional<bool> no_delay;
+
+    /// @brief The size of the kernel's send buffer, in bytes (SO_SNDBUF). The kernel doubles the
+    /// value set to make room for its own bookkeeping, and reports the doubled value, so the value
+    /// read back is halved again to match the value that was set. (see: man 7 socket)
+    std::optional<int> send_buffer_size;
+
+    /// @brief The size of the kernel's receive buffer, in bytes (SO_RCVBUF). Doubled by the kernel
+    /// and halved when read back, just like send_buffer_size. (see: man 7 socket)
+    std::optional<int> receive_buffer_size;
+
+    /// @brief Whether to use the TCP_QUICKACK option, so that received data is acknowledged right
+    /// away rather than after a delay. The kernel may leave quick ack mode again on its own, so it
+    /// must be set again after receiving to stay in effect. (see: man 7 tcp)
+    std::optional<bool> quick_ack;
+
+    /// @brief How long a blocking receive may busy poll the device queue for data before sleeping
+    /// (SO_BUSY_POLL), where zero turns busy polling off. Values above net.core.busy_read require
+    /// CAP_NET_ADMIN. (see: man 7 socket)
+    std::optional<std::chrono::microseconds> busy_poll;
+
+    /// @brief The most unsent bytes that may be queued before the socket stops being reported as
+    /// writable (TCP_NOTSENT_LOWAT), which keeps data from sitting in the kernel long after it was
+    /// written. Read back as -1 when there is no limit. (see: man 7 tcp)
+    std::optional<int> not_sent_low_watermark;
+
+    /// @brief Whether to use the SO_KEEPALIVE option, so that a peer that disappears without
+    /// closing the connection is eventually detected. (see: man 7 socket)
+    std::optional<bool> keep_alive;
+
+    /// @brief How long the connection must be idle before keepalive probes are sent
+    /// (TCP_KEEPIDLE). (see: man 7 tcp)
+    std::optional<std::chrono::seconds> keep_alive_idle;
+
+    /// @brief The time between keepalive probes (TCP_KEEPINTVL). (see: man 7 tcp)
+    std::optional<std::chrono::seconds> keep_alive_interval;
+
+    /// @brief The number of unanswered keepalive probes after which the connection is dropped
+    /// (TCP_KEEPCNT). (see: man 7 tcp)
+    std::optional<int> keep_alive_count;
+};
+
+/// @brief Options used to customize how a connection is established when the remote address
+/// resolves to several endpoints. Connection attempts are raced in the manner of RFC 8305 ("Happy
+/// Eyeballs"): the endpoints are tried in turn, alternating between address families, with each
+/// attempt started a little after the one before it rather than once it has failed. The first
+/// attempt to succeed is kept, and the rest are abandoned.
+struct connect_options {
+    /// @brief How long the first attempt has to succeed before the next one is started alongside
+    /// it. RFC 8305 recommends 250ms.
+    std::chrono::milliseconds connect_delay = std::chrono::milliseconds(250);
+
+    /// @brief How long each later attempt has to itself before the next one is started alongside
+    /// it. An attempt that fails starts the next one right away. RFC 8305 recommends no less than
+    /// 10ms.
+    std::chrono::milliseconds stagger_interval = std::chrono::milliseconds(250);
+
+    /// @brief If nonzero, the longest to wait for a connection to be established. Once it passes,
+    /// every attempt still in progress is abandoned, and the connection fails with
+    /// std::errc::timed_out. Zero means that each attempt may take as long as the system allows.
+    std::chrono::milliseconds timeout = std::chrono::milliseconds(0);
+};
+
 /// @brief A networking entity that allows communication between the host and another endpoint,
 /// local or remote.
 class connection {
@@ -36,7 +112,8 @@ class connection {
     /// @brief Create an unopened connection.
     connection();
 
-    /// @brief Return an open connection created from a connected native socket.
+    /// @brief Return an open connection created from a connected native socket. No system calls
+    /// are made, since the local endpoint is only looked up the first time that it is asked for.
     /// @param socket_fd The open native socket's file descriptor.
     /// @param remote_endpoint An endpoint representing the remote end of the connection.
     /// @return An open connection created from an open native socket.
@@ -72,22 +149,197 @@ class connection {
     /// @param ec An error_code that is set if an error occurs.
     void connect(const resolve_result &remote_endpoints, std::error_code &ec);
 
+    /// @brief Establish a connection to the resolved remote address.
+    /// @param remote_endpoints The resolved remote address that this connection will attempt to
+    /// connect to.
+    /// @param options Options used to customize how the connection is established.
+    void connect(const resolve_result &remote_endpoints, const connect_options &options);
+
+    /// @brief Establish a connection to the resolved remote address.
+    /// @param remote_endpoints The resolved remote address that this connection will attempt to
+    /// connect to.
+    /// @param options Options used to customize how the connection is established.
+    /// @param ec An error_code that is set if an error occurs.
+    void connect(
+        const resolve_result &remote_endpoints,
+        const connect_options &options,
+        std::error_code &ec);
+
+    /// @brief Establish a connection to the resolved remote address, giving up once the timeout
+    /// passes.
+    /// @param remote_endpoints The resolved remote address that this connection will attempt to
+    /// connect to.
+    /// @param timeout The longest to wait for the connection to be established.
+    void connect(const resolve_result &remote_endpoints, std::chrono::milliseconds timeout);
+
+    /// @brief Establish a connection to the resolved remote address, giving up once the timeout
+    /// passes.
+    /// @param remote_endpoints The resolved remote address that this connection will attempt to
+    /// connect to.
+    /// @param timeout The longest to wait for the connection to be established.
+    /// @param ec An error_code that is set if an error occurs, which is std::errc::timed_out if the
+    /// timeout passed.
+    void connect(
+        const resolve_result &remote_endpoints,
+        std::chrono::milliseconds timeout,
+        std::error_code &ec);
+
     /// @brief Close this connection gracefully.
     void disconnect();
 
-    /// @brief Send the data contained in the given buffer to the remote endpoint of this
-    /// connection.
+    /// @brief Send the data referred to by the given view to the remote endpoint of this
+    /// connection. Blocks until all of the data has been sent, even if the underlying socket is in
+    /// non-blocking mode.
     /// @param data The data to be sent.
     /// @param flags A bitfield of send_flags constants used to customize this call to send().
-    void send(const buffer &data, send_flags_mask flags = send_flags::none) const;
+    void send(buffer_view data, send_flags_mask flags = send_flags::none) const;
 
-    /// @brief Send the data contained in the given buffer to the remote endpoint of this
-    /// connection.
+    /// @brief Send the data referred to by the given view to the remote endpoint of this
+    /// connection. Blocks until all of the data has been sent, even if the underlying socket is in
+    /// non-blocking mode.
     /// @param data The data to be sent.
     /// @param ec An error_code that is set if an error occurs.
     /// @param flags A bitfield of send_flags constants used to customize this call to send().
     void send(
-        const buffer &data, std::error_code &ec, send_flags_mask flags = send_flags::none) const;
+        buffer_view data, std::error_code &ec, send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Send as much of the data referred to by the given view as the connection can accept
+    /// without blocking, starting at the specified offset.
+    /// @param data The data to be sent.
+    /// @param offset The number of bytes at the start of data to skip.
+    /// @param flags A bitfield of send_flags constants used to customize this call to try_send().
+    /// @return The number of bytes sent, which is zero if the connection cannot accept any data
+    /// right now.
+    size_t try_send(
+        buffer_view data, size_t offset = 0, send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Send as much of the data referred to by the given view as the connection can accept
+    /// without blocking, starting at the specified offset.
+    /// @param data The data to be sent.
+    /// @param offset The number of bytes at the start of data to skip.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param flags A bitfield of send_flags constants used to customize this call to try_send().
+    /// @return The number of bytes sent, which is zero if the connection cannot accept any data
+    /// right now.
+    size_t try_send(
+        buffer_view data,
+        size_t offset,
+        std::error_code &ec,
+        send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Send the data referred to by a sequence of views, in order, to the remote endpoint of
+    /// this connection, without first joining them together. Blocks until all of the data has been
+    /// sent, even if the underlying socket is in non-blocking mode.
+    /// @param data The data to be sent.
+    /// @param flags A bitfield of send_flags constants used to customize this call to send().
+    void send(buffer_sequence data, send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Send the data referred to by a sequence of views, in order, to the remote endpoint of
+    /// this connection, without first joining them together. Blocks until all of the data has been
+    /// sent, even if the underlying socket is in non-blocking mode.
+    /// @param data The data to be sent.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param flags A bitfield of send_flags constants used to customize this call to send().
+    void send(
+        buffer_sequence data, std::error_code &ec, send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Send as much of the data referred to by a sequence of views as the connection can
+    /// accept without blocking, starting at the specified offset into the sequence.
+    /// @param data The data to be sent.
+    /// @param offset The number of bytes at the start of the sequence to skip. (i.e. the total
+    /// returned by earlier calls for the same data)
+    /// @param flags A bitfield of send_flags constants used to customize this call to try_send().
+    /// @return The number of bytes sent, which is zero if the connection cannot accept any data
+    /// right now.
+    size_t try_send(
+        buffer_sequence data, size_t offset = 0, send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Send as much of the data referred to by a sequence of views as the connection can
+    /// accept without blocking, starting at the specified offset into the sequence.
+    /// @param data The data to be sent.
+    /// @param offset The number of bytes at the start of the sequence to skip. (i.e. the total
+    /// returned by earlier calls for the same data)
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param flags A bitfield of send_flags constants used to customize this call to try_send().
+    /// @return The number of bytes sent, which is zero if the connection cannot accept any data
+    /// right now.
+    size_t try_send(
+        buffer_sequence data,
+        size_t offset,
+        std::error_code &ec,
+        send_flags_mask flags = send_flags::none) const;
+
+    /// @brief Receive up to size bytes of data sent from the remote endpoint of this connection
+    /// into storage owned by the caller, without allocating. If the remote end of this connection
+    /// is disconnected, then no data is received and this connection will return to a closed state.
+    /// @param data The storage to receive the data into.
+    /// @param size The size of the storage, and the most bytes to be received.
+    /// @param flags A bitfield of receive_flags constants used to customize this call to
+    /// receive_into().
+    /// @return The number of bytes received.
+    size_t receive_into(char *data, size_t size, receive_flags_mask flags = receive_flags::none);
+
+    /// @brief Receive up to size bytes of data sent from the remote endpoint of this connection
+    /// into storage owned by the caller, without allocating. If the remote end of this connection
+    /// is disconnected, or an error occurs, then no data is received and this connection will
+    /// return to a closed state.
+    /// @param data The storage to receive the data into.
+    /// @param size The size of the storage, and the most bytes to be received.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param flags A bitfield of receive_flags constants used to customize this call to
+    /// receive_into().
+    /// @return The number of bytes received.
+    size_t receive_into(
+        char *data,
+        size_t size,
+        std::error_code &ec,
+        receive_flags_mask flags = receive_flags::none);
+
+    /// @brief Receive data sent from the remote endpoint of this connection into a buffer owned by
+    /// the caller, without allocating. At most data.size() bytes are received, and the buffer is
+    /// not resized. If the remote end of this connection is disconnected, then no data is received
+    /// and this connection will return to a closed state.
+    /// @param data The buffer to receive the data into.
+    /// @param flags A bitfield of receive_flags constants used to customize this call to
+    /// receive_into().
+    /// @return The number of bytes received.
+    size_t receive_into(buffer &data, receive_flags_mask flags = receive_flags::none);
+
+    /// @brief Receive data sent from the remote endpoint of this connection into a buffer owned by
+    /// the caller, without allocating. At most data.size() bytes are received, and the buffer is
+    /// not resized. If the remote end of this connection is disconnected, or an error occurs, then
+    /// no data is received and this connection will return to a closed state.
+    /// @param data The buffer to receive the data into.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param flags A bitfield of receive_flags constants used to customize this call to
+    /// receive_into().
+    /// @return The number of bytes received.
+    size_t receive_into(
+        buffer &data, std::error_code &ec, receive_flags_mask flags = receive_flags::none);
+
+    /// @brief Receive data sent from the remote endpoint of this connection into a sequence of
+    /// buffers, filling each buffer in turn before moving on to the next. The buffers are not
+    /// resized. If the remote end of this connection is disconnected, then no data is received and
+    /// this connection will return to a closed state.
+    /// @param data The buffers to receive the data into.
+    /// @param flags A bitfield of receive_flags constants used to customize this call to
+    /// receive().
+    /// @return The number of bytes received.
+    size_t receive(std::vector<buffer> &data, receive_flags_mask flags = receive_flags::none);
+
+    /// @brief Receive data sent from the remote endpoint of this connection into a sequence of
+    /// buffers, filling each buffer in turn before moving on to the next. The buffers are not
+    /// resized. If the remote end of this connection is disconnected, or an error occurs, then no
+    /// data is received and this connection will return to a closed state.
+    /// @param data The buffers to receive the data into.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @param flags A bitfield of receive_flags constants used to customize this call to
+    /// receive().
+    /// @return The number of bytes received.
+    size_t receive(
+        std::vector<buffer> &data,
+        std::error_code &ec,
+        receive_flags_mask flags = receive_flags::none);
 
     /// @brief Return a buffer containing data sent from the remote endpoint of this connection. If
     /// the remote end of this connection is disconnected, then the buffer will be empty and this
@@ -134,12 +386,34 @@ class connection {
     /// @return True if there is data available to read from this connection.
     bool has_data_available() const;
 
+    /// @brief Set the options of this connection's socket. Options that are left unset are not
+    /// changed.
+    /// @param options The options to be set.
+    void set_options(const connection_options &options);
+
+    /// @brief Set the options of this connection's socket. Options that are left unset are not
+    /// changed.
+    /// @param options The options to be set.
+    /// @param ec An error_code that is set if an error occurs. Options before the one that failed
+    /// are still set.
+    void set_options(const connection_options &options, std::error_code &ec);
+
+    /// @brief Return the options in effect for this connection's socket.
+    /// @return The options in effect for this connection's socket.
+    connection_options options() const;
+
+    /// @brief Return the options in effect for this connection's socket.
+    /// @param ec An error_code that is set if an error occurs.
+    /// @return The options in effect for this connection's socket.
+    connection_options options(std::error_code &ec) const;
+
     /// @brief Return the native socket associated with this connection.
     /// @return The native socket associated with this connection.
     socket_type native_socket() const;
 
     /// @brief Return the local endpoint that this connection is bound to. Invalid if no
-    /// connection is established.
+    /// connection is established. For connections created with from_native_socket(), the first
+    /// call looks the endpoint up. This may be called from several threads at once.
     /// @return The local endpoint that this connection is bound to.
     endpoint local_endpoint() const;
 
@@ -150,7 +424,12 @@ class connection {
 
    private:
     socket_type socket_ = 0;
-    endpoint local_endpoint_;
+
+    // Connections created from native sockets look their local endpoint up on first use
+    mutable endpoint local_endpoint_;
+    mutable std::atomic<bool> is_local_endpoint_known_ = false;
+    mutable std::mutex local_endpoint_mutex_;
+
     endpoint remote_endpoint_;
 };
 
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "yonaa/connection.hpp"
+#include "yonaa/detail/wakeup.hpp"
+#include "yonaa/resolve.hpp"
+
+namespace yonaa {
+
+/// @brief Identifies a request made to a connector, so that it can be canceled.
+using connect_request_id = uint64_t;
+
+/// @brief Options used to customize the behavior of a connector.
+struct connector_config {
+    /// @brief The most requests that may be unfinished at once. Requests made while this many are
+    /// unfinished fail right away with std::errc::resource_unavailable_try_again, rather than
+    /// blocking the caller.
+    size_t max_pending_requests = 4096;
+
+    /// @brief The options used for requests that do not specify their own.
+    connect_options default_options;
+};
+
+/// @brief Establishes connections without blocking the threads that ask for them. The connection
+/// attempts of every request are made by a single network thread of its own, which waits on all of
+/// them at once, so that thousands of connections can be brought up together.
+class connector {
+   public:
+    /// @brief The signature for a callback function called with the result of a request. The
+    /// connection is open (and blocking) unless the error_code is set, which is
+    /// std::errc::timed_out if the request timed out, and std::errc::operation_canceled if it was
+    /// canceled.
+    using connect_handler = std::function<void(connection, std::error_code)>;
+
+    /// @brief The signature for a function that runs a task on the thread that should receive a
+    /// result, such as one that posts the task to the caller's network thread.
+    using executor = std::function<void(std::function<void()>)>;
+
+   public:
+    /// @brief Create a connector and start its network thread.
+    /// @param config Options used to customize the behavior of this connector.
+    explicit connector(const connector_config &config = connector_config());
+
+    /// @brief Cancel every unfinished request, and then stop the network thread of this connector.
+    ~connector();
+
+    // Disable copies and moves --------------------------------------------------------------------
+
+    connector(const connector &other)             = delete;
+    connector &operator=(const connector &other)  = delete;
+    connector(const connector &&other)            = delete;
+    connector &operator=(const connector &&other) = delete;
+
+    // ---------------------------------------------------------------------------------------------
+
+    /// @brief Start establishing a connection to the resolved remote address without blocking. The
+    /// handler is called exactly once: with the connection, or with an error if the request fails,
+    /// times out or is canceled.
+    /// @param remote_endpoints The resolved remote address to connect to.
+    /// @param handler The function to be called with the result.
+    /// @return An identifier for the request, to be passed to cancel().
+    connect_request_id async_connect(
+        const resolve_result &remote_endpoints, connect_handler handler);
+
+    /// @brief Start establishing a connection to the resolved remote address without blocking. The
+    /// handler is called exactly once: with the connection, or with an error if the request fails,
+    /// times out or is canceled.
+    /// @param remote_endpoints The resolved remote address to connect to.
+    /// @param handler The function to be called with the result.
+    /// @param options Options used to customize how the connection is established.
+    /// @param handler_executor If set, the handler is called through this function rather than on
+    /// this connector's network thread.
+    /// @return An identifier for the request, to be passed to cancel().
+    connect_request_id async_connect(
+        const resolve_result &remote_endpoints,
+        connect_handler handler,
+        const connect_options &options,
+        executor handler_executor = executor());
+
+    /// @brief Cancel an unfinished request, whose handler is then called with
+    /// std::errc::operation_canceled.
+    /// @param id The request to be canceled.
+    /// @return True if the request was canceled, and false if it had already finished.
+    bool cancel(connect_request_id id);
+
+    /// @brief Return the number of requests that have not finished yet.
+    /// @return The number of requests that have not finished yet.
+    size_t pending_requests() const;
+
+   private:
+    struct request {
+        resolve_result remote_endpoints;
+        connect_options options;
+        connect_handler handler;
+        executor handler_executor;
+    };
+
+    void network_thread_function_();
+    static void complete_(request &&r, connection conn, std::error_code ec);
+
+   private:
+    connector_config config_;
+
+    mutable std::mutex mutex_;
+    std::map<connect_request_id, request> submitted_;  // Requests not yet taken by the thread
+    std::set<connect_request_id> in_progress_;         // Requests taken by the thread
+    std::vector<connect_request_id> canceled_;         // Requests taken by the thread, canceled
+    connect_request_id next_id_ = 1;
+    bool stopping_              = false;
+
+    detail::wakeup_event wakeup_;
+    std::thread thread_;
+};
+
+}  // namespace yonaa
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "yonaa/connection.hpp"
+#include "yonaa/resolve.hpp"
+#include "yonaa/types.hpp"
+
+namespace yonaa::detail {
+
+/// @brief The state of a set of connection attempts raced as described by connect_options. The
+/// race does not wait on its own; the caller waits for the sockets of the attempts in progress to
+/// become writable (or to report an error) however it likes, and advances the race as they do.
+class connect_race {
+   public:
+    using clock_type = std::chrono::steady_clock;
+
+   public:
+    /// @brief Prepare a race between connection attempts to the endpoints provided. No attempt is
+    /// started until start_due_attempts() is called.
+    /// @param remote_endpoints The remote address to connect to.
+    /// @param options Options used to customize how the connection attempts are made.
+    connect_race(const resolve_result &remote_endpoints, const connect_options &options);
+
+    /// @brief Close the sockets of every attempt in progress, along with the socket of a
+    /// successful attempt that was not released.
+    ~connect_race();
+
+    // Disable copies and moves --------------------------------------------------------------------
+
+    connect_race(const connect_race &other)             = delete;
+    connect_race &operator=(const connect_race &other)  = delete;
+    connect_race(const connect_race &&other)            = delete;
+    connect_race &operator=(const connect_race &&other) = delete;
+
+    // ---------------------------------------------------------------------------------------------
+
+    /// @brief Start the attempts that are due: the next attempt once its time comes, or right away
+    /// if no other attempt is in progress. The sockets of new attempts are appended to attempts().
+    void start_due_attempts();
+
+    /// @brief Finish an attempt whose socket was reported writable, or in error. The socket is
+    /// removed from attempts(), and closed if the attempt failed.
+    /// @param socket_fd The socket of the attempt.
+    void finish_attempt(socket_type socket_fd);
+
+    /// @brief Return true if the race is over, because an attempt succeeded, every attempt failed
+    /// or the timeout passed, and false otherwise.
+    /// @return True if the race is over, and false otherwise.
+    bool is_finished() const;
+
+    /// @brief Return the sockets of the attempts in progress, to be waited on for writability.
+    /// @return The sockets of the attempts in progress.
+    const std::vector<socket_type> &attempts() const { return attempts_; }
+
+    /// @brief Return the time, in milliseconds, until the next attempt is due or the timeout
+    /// passes, whichever comes first.
+    /// @return The time, in milliseconds, until the next attempt is due or the timeout passes, or
+    /// -1 if neither is pending.
+    int timeout_millis() const;
+
+    /// @brief Take the socket of the successful attempt, in blocking mode, and close the sockets of
+    /// every other attempt. Must only be called once the race is over.
+    /// @return The socket of the successful attempt, or 0 (with errno set by the last failure, or
+    /// to ETIMEDOUT) if there is none.
+    socket_type release();
+
+   private:
+    bool is_timed_out_(clock_type::time_point now) const;
+    void close_attempts_();
+
+   private:
+    connect_options options_;
+    resolve_result candidates_;
+    size_t next_candidate_;
+    clock_type::time_point next_attempt_time_;
+    clock_type::time_point deadline_;
+
+    std::vector<socket_type> attempts_;  // Attempts that are still in progress
+    socket_type connected_fd_;
+    int last_error_;
+};
+
+}  // namespace yonaa::detail
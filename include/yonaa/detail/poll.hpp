@@ -2,6 +2,11 @@
 
 #include <poll.h>
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define YONAA_HAS_EPOLL 1
+#endif
+
 #include <vector>
 
 #include "bitmask/bitmask.hpp"
@@ -22,13 +27,31 @@ enum class socket_status {
 BITMASK_DEFINE_MAX_ELEMENT(socket_status, writable)
 using socket_status_mask = bitmask::bitmask<socket_status>;
 
+/// @brief The mechanisms that a poll_group can use to wait for status changes on its sockets.
+enum class poll_backend {
+    poll,   /// @brief Use poll(2). Every call scans every socket in the group.
+    epoll,  /// @brief Use epoll(7). Sockets are registered with the kernel once, and only the
+            /// sockets that are ready are returned. (Linux only)
+};
+
+/// @brief The backend used by a poll_group when none is specified.
+#if defined(YONAA_HAS_EPOLL)
+constexpr poll_backend default_poll_backend = poll_backend::epoll;
+#else
+constexpr poll_backend default_poll_backend = poll_backend::poll;
+#endif
+
 /// @brief Return the status of a particular socket.
 /// @param socket_fd The socket to be polled.
 /// @param timeout_millis The timeout, in milliseconds, to wait for a state change if the socket
 /// does not have one. A negative timeout will cause this function to block until a state change
 /// occurs.
+/// @param config The statuses to wait for.
 /// @return The status of a particular socket.
-socket_status_mask poll_socket(socket_type socket_fd, int timeout_millis = 0);
+socket_status_mask poll_socket(
+    socket_type socket_fd,
+    int timeout_millis        = 0,
+    socket_status_mask config = socket_status::readable | socket_status::writable);
 
 /// @brief A data structure to relate socket file descriptors to socket statuses.
 struct socket_status_info {
@@ -42,7 +65,19 @@ using poll_result = std::vector<socket_status_info>;
 /// @brief A utility for polling multiple sockets.
 class poll_group {
    public:
-    poll_group(socket_status_mask config = socket_status::readable | socket_status::writable);
+    /// @brief Create an empty poll group.
+    /// @param config The statuses that this poll group should watch its sockets for.
+    /// @param backend The mechanism used to wait for status changes. If the backend is not
+    /// available on this system, poll_backend::poll is used instead.
+    /// @param edge_triggered True if a status change should only be reported once, rather than on
+    /// every call to poll() for as long as it persists. Only honored by poll_backend::epoll.
+    poll_group(
+        socket_status_mask config = socket_status::readable | socket_status::writable,
+        poll_backend backend      = default_poll_backend,
+        bool edge_triggered       = false);
+
+    /// @brief Cleanup a poll group.
+    ~poll_group();
 
     // Disable copies and moves --------------------------------------------------------------------
 
@@ -61,6 +96,12 @@ class poll_group {
     /// @param socket_fd The socket to be removed.
     void remove_socket(socket_type socket_fd);
 
+    /// @brief Change the statuses that this poll group watches a particular socket for. Sockets
+    /// are watched for the statuses given to the constructor until this is called.
+    /// @param socket_fd The socket to be modified. It must already be in this poll group.
+    /// @param config The statuses that this poll group should watch the socket for.
+    void modify_socket(socket_type socket_fd, socket_status_mask config);
+
     /// @brief Return the status of all sockets in this poll group that experienced status changes.
     /// @param timeout_millis The timeout, in milliseconds, to wait for a state change if the socket
     /// does not have one. A negative timeout will cause this function to block until a state change
@@ -72,9 +113,24 @@ class poll_group {
     /// @return The number of sockets associated with this poll_group.
     size_t size() const;
 
+    /// @brief Return the mechanism that this poll group uses to wait for status changes.
+    /// @return The mechanism that this poll group uses to wait for status changes.
+    poll_backend backend() const;
+
    private:
+    poll_backend backend_;
+    size_t size_;
+
+    // poll_backend::poll
     std::vector<pollfd> pfds_;
     int pfd_config_;
+
+#if defined(YONAA_HAS_EPOLL)
+    // poll_backend::epoll
+    int epoll_fd_;
+    uint32_t epoll_config_;
+    std::vector<epoll_event> epoll_events_;
+#endif
 };
 
 }  // namespace yonaa::detail
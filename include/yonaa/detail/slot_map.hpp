@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace yonaa::detail {
+
+/// @brief An unordered container that hands out a key for every value inserted into it. Lookups,
+/// insertions and removals by key take constant time, and the values are stored contiguously, so
+/// iterating over them is as fast as iterating over a std::vector.
+///
+/// Each key holds the index of a slot and the generation of that slot. A slot's generation changes
+/// every time its value is removed, so the key of a removed value does not find the value that
+/// later reuses its slot. Keys are never zero, and only use the low key_bits bits, leaving the rest
+/// for the caller to pack its own data into.
+/// @tparam T The type of the values being stored.
+template<typename T>
+class slot_map {
+   public:
+    using key_type       = uint64_t;
+    using iterator       = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    static constexpr size_t index_bits      = 32;
+    static constexpr size_t generation_bits = 24;
+    static constexpr size_t key_bits        = index_bits + generation_bits;
+
+    /// @brief Construct a value in place, and return the key used to find it.
+    /// @param args The arguments to construct the value with.
+    /// @return The key used to find the new value.
+    template<typename... Args>
+    key_type emplace(Args &&...args) {
+        uint32_t slot_index;
+        if (free_slots_.empty()) {
+            slot_index = (uint32_t)slots_.size();
+            slots_.push_back(slot{invalid_index, 1});
+        } else {
+            slot_index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+
+        values_.emplace_back(std::forward<Args>(args)...);
+        value_slots_.push_back(slot_index);
+        slots_[slot_index].value_index = (uint32_t)(values_.size() - 1);
+
+        return make_key(slot_index, slots_[slot_index].generation);
+    }
+
+    /// @brief Add a value, and return the key used to find it.
+    /// @param value The value to be added.
+    /// @return The key used to find the new value.
+    key_type insert(T value) { return emplace(std::move(value)); }
+
+    /// @brief Remove the value with the specified key. The last value is moved into its place, so
+    /// pointers to that value are invalidated.
+    /// @param key The key of the value to be removed.
+    /// @return True if a value was removed, and false if no value has the specified key.
+    bool erase(key_type key) {
+        slot *s = find_slot(key);
+        if (!s) return false;
+
+        uint32_t value_index = s->value_index;
+        uint32_t last_index  = (uint32_t)(values_.size() - 1);
+
+        // Note: Swapping rather than move-assigning over the removed value lets it be destroyed
+        // normally, even for types whose move assignment does not release what they held.
+        if (value_index != last_index) {
+            std::swap(values_[value_index], values_[last_index]);
+            value_slots_[value_index] = value_slots_[last_index];
+
+            slots_[value_slots_[value_index]].value_index = value_index;
+        }
+        values_.pop_back();
+        value_slots_.pop_back();
+
+        // Retire the key, and make the slot available for reuse
+        s->value_index = invalid_index;
+        s->generation  = (s->generation + 1) & generation_mask;
+        if (s->generation == 0) s->generation = 1;
+        free_slots_.push_back((uint32_t)(s - slots_.data()));
+
+        return true;
+    }
+
+    /// @brief Return a non-owning pointer to the value with the specified key, or nullptr if no
+    /// value has the specified key.
+    /// @param key The key of the value to search for.
+    /// @return A non-owning pointer to the value with the specified key, or nullptr if no value
+    /// has the specified key.
+    T *find(key_type key) {
+        slot *s = find_slot(key);
+        return s ? &values_[s->value_index] : nullptr;
+    }
+
+    /// @brief Return a non-owning pointer to the value with the specified key, or nullptr if no
+    /// value has the specified key.
+    /// @param key The key of the value to search for.
+    /// @return A non-owning pointer to the value with the specified key, or nullptr if no value
+    /// has the specified key.
+    const T *find(key_type key) const { return const_cast<slot_map *>(this)->find(key); }
+
+    /// @brief Return true if a value has the specified key, and false otherwise.
+    /// @param key The key to search for.
+    /// @return True if a value has the specified key, and false otherwise.
+    bool contains(key_type key) const { return find(key) != nullptr; }
+
+    /// @brief Return the number of values in this slot map.
+    /// @return The number of values in this slot map.
+    size_t size() const { return values_.size(); }
+
+    /// @brief Return true if this slot map holds no values, and false otherwise.
+    /// @return True if this slot map holds no values, and false otherwise.
+    bool empty() const { return values_.empty(); }
+
+    /// @brief Allocate enough storage for the specified number of values.
+    /// @param capacity The number of values to allocate storage for.
+    void reserve(size_t capacity) {
+        values_.reserve(capacity);
+        value_slots_.reserve(capacity);
+        slots_.reserve(capacity);
+    }
+
+    // Iteration, in no particular order ----------------------------------------------------------
+
+    iterator begin() { return values_.begin(); }
+    iterator end() { return values_.end(); }
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end() const { return values_.end(); }
+
+   private:
+    struct slot {
+        uint32_t value_index;  // Index into values_, or invalid_index if the slot is free
+        uint32_t generation;
+    };
+
+    static constexpr uint32_t invalid_index   = UINT32_MAX;
+    static constexpr uint64_t index_mask      = ((uint64_t)1 << index_bits) - 1;
+    static constexpr uint32_t generation_mask = ((uint32_t)1 << generation_bits) - 1;
+
+    static key_type make_key(uint32_t slot_index, uint32_t generation) {
+        return ((key_type)generation << index_bits) | slot_index;
+    }
+
+    slot *find_slot(key_type key) {
+        uint64_t slot_index = key & index_mask;
+        uint32_t generation = (uint32_t)(key >> index_bits);
+
+        if (slot_index >= slots_.size()) return nullptr;
+
+        slot &s = slots_[slot_index];
+        if (s.value_index == invalid_index || s.generation != generation) return nullptr;
+
+        return &s;
+    }
+
+   private:
+    std::vector<T> values_;              // The values, stored contiguously
+    std::vector<uint32_t> value_slots_;  // The slot of each value, parallel to values_
+    std::vector<slot> slots_;
+    std::vector<uint32_t> free_slots_;
+};
+
+}  // namespace yonaa::detail
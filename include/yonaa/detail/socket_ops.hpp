@@ -1,5 +1,11 @@
 #pragma once
 
+#include <sys/uio.h>
+
+#include <vector>
+
+#include "yonaa/acceptor.hpp"
+#include "yonaa/connection.hpp"
 #include "yonaa/endpoint.hpp"
 #include "yonaa/resolve.hpp"
 #include "yonaa/types.hpp"
@@ -7,11 +13,14 @@
 namespace yonaa::detail::socket_ops {
 
 /// @brief Return a socket that is connected to the specified endpoint, or 0 if the connection could
-/// not be established.
+/// not be established. When there are several endpoints, connection attempts to them are raced as
+/// described by connect_options, so that an unreachable endpoint does not hold up the rest.
 /// @param remote_endpoints The remote address to connect to.
-/// @return A socket that is connected to the specified endpoint, or 0 if the connection could not
-/// be established.
-socket_type create_connected_socket(const resolve_result &remote_endpoints);
+/// @param options Options used to customize how the connection attempts are made.
+/// @return A (blocking) socket that is connected to the specified endpoint, or 0 (with errno set by
+/// the last failure) if the connection could not be established.
+socket_type create_connected_socket(
+    const resolve_result &remote_endpoints, const connect_options &options = connect_options());
 
 /// @brief Return a socket that is primed to accept incoming connections at the local endpoint
 /// provided, or 0 if such a socket could not be created.
@@ -20,15 +29,88 @@ socket_type create_connected_socket(const resolve_result &remote_endpoints);
 /// socket.
 /// @param reuse_addr True if this socket should use the SO_REUSEADDR option when configuring its
 /// socket. (see: man 7 ip).
+/// @param reuse_port True if this socket should use the SO_REUSEPORT option when configuring its
+/// socket. (see: man 7 socket).
+/// @return A socket that is primed to accept incoming connections at the local endpoint provided,
+/// or 0 if such a socket could not be created.
+socket_type create_listening_socket(
+    const resolve_result &local_endpoints,
+    uint64_t backlog_size,
+    bool reuse_addr = false,
+    bool reuse_port = false);
+
+/// @brief Return a socket that is primed to accept incoming connections at the local endpoint
+/// provided, or 0 if such a socket could not be created.
+/// @param local_endpoints The local address to wait for incoming connections at.
+/// @param options Options used to tune the socket.
 /// @return A socket that is primed to accept incoming connections at the local endpoint provided,
 /// or 0 if such a socket could not be created.
 socket_type create_listening_socket(
-    const resolve_result &local_endpoints, uint64_t backlog_size, bool reuse_addr = false);
+    const resolve_result &local_endpoints, const acceptor_options &options);
+
+/// @brief Return a socket that is primed to accept incoming connections for each distinct local
+/// endpoint provided that one could be created for. When an IPv4 endpoint is among them, IPv6
+/// sockets only accept IPv6 connections, so that an unspecified address of each family can share a
+/// port.
+/// @param local_endpoints The local addresses to wait for incoming connections at.
+/// @param options Options used to tune the sockets.
+/// @return The sockets, in the order of their endpoints. Empty if no socket could be created, with
+/// errno set by the last failure.
+std::vector<socket_type> create_listening_sockets(
+    const resolve_result &local_endpoints, const acceptor_options &options);
+
+/// @brief Put a socket into (or take it out of) non-blocking mode.
+/// @param socket_fd The socket to configure.
+/// @param non_blocking True if operations on the socket should fail with EAGAIN rather than block.
+/// @return True if the socket was configured, and false otherwise.
+bool set_non_blocking(socket_type socket_fd, bool non_blocking);
+
+/// @brief Set the options of a connected socket. Options that are left unset are not changed.
+/// @param socket_fd The socket to configure.
+/// @param options The options to be set.
+/// @return True if every option was set, and false (with errno set) otherwise.
+bool set_connection_options(socket_type socket_fd, const connection_options &options);
+
+/// @brief Read the options in effect for a connected socket.
+/// @param socket_fd The socket to query.
+/// @param options The options, which are filled in with the values in effect.
+/// @return True if every option was read, and false (with errno set) otherwise.
+bool get_connection_options(socket_type socket_fd, connection_options &options);
+
+/// @brief Send the data described by a sequence of iovecs with a single call to sendmsg(). At
+/// most IOV_MAX iovecs are sent at once. (see: man 2 sendmsg)
+/// @param socket_fd The socket to send the data with.
+/// @param iovecs The data to be sent.
+/// @param iovec_count The number of iovecs in the sequence.
+/// @param flags The flags to pass to sendmsg().
+/// @return The number of bytes sent, or -1 (with errno set) if an error occurs.
+ssize_t send_iovecs(socket_type socket_fd, const iovec *iovecs, size_t iovec_count, int flags);
+
+/// @brief Receive data into the storage described by a sequence of iovecs with a single call to
+/// recvmsg(). At most IOV_MAX iovecs are filled at once. (see: man 2 recvmsg)
+/// @param socket_fd The socket to receive the data with.
+/// @param iovecs The storage that the data should be received into, filled in order.
+/// @param iovec_count The number of iovecs in the sequence.
+/// @param flags The flags to pass to recvmsg().
+/// @return The number of bytes received, 0 if the remote end of the socket is disconnected, or -1
+/// (with errno set) if an error occurs.
+ssize_t receive_iovecs(socket_type socket_fd, const iovec *iovecs, size_t iovec_count, int flags);
+
+/// @brief Move past the first bytes of the data described by a sequence of iovecs, so that a
+/// partial send or receive can be resumed from where it stopped.
+/// @param iovecs The first iovec of the sequence, which is moved past every iovec that was used up.
+/// @param iovec_count The number of iovecs in the sequence, which is reduced to match.
+/// @param bytes The number of bytes to move past.
+void advance_iovecs(iovec *&iovecs, size_t &iovec_count, size_t bytes);
 
 /// @brief Gracefully close an open socket.
 /// @param socket_fd The socket to close.
 void close_socket(socket_type socket_fd);
 
+/// @brief Close a socket that is being abandoned, without disturbing the errno that explains why.
+/// @param socket_fd The socket to close.
+void close_preserving_errno(socket_type socket_fd);
+
 /// @brief Return an endpoint representing the local end of this socket.
 /// @param socket_fd The socket to query.
 /// @return An endpoint representing the local end of this socket.
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yonaa::detail {
+
+/// @brief A sequence of tasks that a thread_pool runs one at a time, in the order that they were
+/// submitted.
+struct strand {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    bool is_scheduled = false;
+};
+
+/// @brief A fixed-size pool of worker threads. Each worker has its own task queue, and workers
+/// that run out of tasks steal from the other queues.
+class thread_pool {
+   public:
+    /// @brief Create a thread pool and start its workers.
+    /// @param thread_count The number of worker threads.
+    /// @param max_queued_tasks The number of tasks that may be waiting to run before submit()
+    /// blocks the submitting thread.
+    thread_pool(size_t thread_count, size_t max_queued_tasks);
+
+    /// @brief Run every task that has already been submitted, and then stop the workers.
+    ~thread_pool();
+
+    // Disable copies and moves --------------------------------------------------------------------
+
+    thread_pool(const thread_pool &other)             = delete;
+    thread_pool &operator=(const thread_pool &other)  = delete;
+    thread_pool(const thread_pool &&other)            = delete;
+    thread_pool &operator=(const thread_pool &&other) = delete;
+
+    // ---------------------------------------------------------------------------------------------
+
+    /// @brief Queue a task to be run by one of the workers. Blocks while the pool is full, unless
+    /// called from one of the workers.
+    /// @param task The task to be run.
+    void submit(std::function<void()> task);
+
+    /// @brief Queue a task to be run by one of the workers after every task previously submitted
+    /// to the same strand. Blocks while the pool is full, unless called from one of the workers.
+    /// @param s The strand that the task belongs to.
+    /// @param task The task to be run.
+    void submit(const std::shared_ptr<strand> &s, std::function<void()> task);
+
+    /// @brief Return true if the calling thread is one of this pool's workers, and false otherwise.
+    /// @return True if the calling thread is one of this pool's workers, and false otherwise.
+    bool is_worker_thread() const;
+
+    /// @brief Return the number of worker threads in this pool.
+    /// @return The number of worker threads in this pool.
+    size_t size() const;
+
+   private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_function_(size_t index);
+    void wait_for_space_();
+    bool try_reserve_space_();
+    void push_(std::function<void()> runnable);
+    bool try_pop_(size_t index, std::function<void()> &runnable);
+    void run_strand_(const std::shared_ptr<strand> &s);
+    void task_started_();
+
+   private:
+    size_t max_queued_tasks_;
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_queue_;
+
+    std::atomic<size_t> queued_tasks_;  // Submitted tasks that have not started running
+    std::atomic<size_t> runnables_;     // Entries in the worker queues
+    std::atomic<size_t> unfinished_;    // Entries in the worker queues or running
+    std::atomic<bool> stopping_;
+
+    // Note: The mutex is only taken by workers that are about to sleep, by submitters that must
+    // block, and by whoever wakes them.
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable space_available_;
+    std::atomic<size_t> sleeping_workers_;
+    std::atomic<size_t> blocked_submitters_;
+};
+
+}  // namespace yonaa::detail
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "yonaa/types.hpp"
+
+namespace yonaa::detail {
+
+/// @brief A file descriptor that can be added to a poll_group and made readable from any thread,
+/// used to interrupt a blocking poll. (see: eventfd, "self-pipe trick")
+class wakeup_event {
+   public:
+    /// @brief Create a wakeup event.
+    wakeup_event();
+
+    /// @brief Cleanup a wakeup event.
+    ~wakeup_event();
+
+    // Disable copies and moves --------------------------------------------------------------------
+
+    wakeup_event(const wakeup_event &other)             = delete;
+    wakeup_event &operator=(const wakeup_event &other)  = delete;
+    wakeup_event(const wakeup_event &&other)            = delete;
+    wakeup_event &operator=(const wakeup_event &&other) = delete;
+
+    // ---------------------------------------------------------------------------------------------
+
+    /// @brief Make this wakeup event readable. Safe to call from any thread.
+    void notify();
+
+    /// @brief Make this wakeup event unreadable again, consuming every pending notification.
+    void reset();
+
+    /// @brief Return the file descriptor to be polled for readability.
+    /// @return The file descriptor to be polled for readability.
+    socket_type native_handle() const;
+
+   private:
+    socket_type read_fd_;
+    socket_type write_fd_;
+};
+
+}  // namespace yonaa::detail
@@ -2,17 +2,20 @@
 
 #include <string>
 
-#include "yonaa/buffer.hpp"
 #include "yonaa/types.hpp"
 
 namespace yonaa {
 
 /// @brief A unit of networking, used to store the address of a host computer.
+///
+/// The address is stored inside the endpoint itself, so endpoints never allocate, and copying one
+/// is a plain copy of its bytes.
 struct endpoint {
-    /// @brief Create an empty endpoint.
+    /// @brief Create an empty endpoint, whose address is zeroed.
     endpoint();
 
-    /// @brief Return an endpoint created from a native address structure.
+    /// @brief Return an endpoint created from a native address structure. Addresses larger than a
+    /// sockaddr_storage are truncated.
     /// @param protocol The protocol associated with the native address structure. (see: man 7 ip)
     /// @param addr The native address structure.
     /// @param addr_size The size (in bytes) of the native address structure.
@@ -60,6 +63,7 @@ struct endpoint {
 
    private:
     protocol_type protocol_;
-    buffer storage_;
+    address_size_type size_;
+    address_storage_type storage_;
 };
 }  // namespace yonaa
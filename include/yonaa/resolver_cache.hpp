@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "yonaa/resolve.hpp"
+
+namespace yonaa {
+
+/// @brief Options used to customize the behavior of a resolver_cache.
+struct resolver_cache_config {
+    /// @brief How long a successful resolution is reused for.
+    std::chrono::milliseconds ttl = std::chrono::seconds(60);
+
+    /// @brief How long a failed resolution is reused for, so that a name that does not resolve is
+    /// not looked up again on every attempt. Zero means that failures are not cached.
+    std::chrono::milliseconds negative_ttl = std::chrono::seconds(5);
+
+    /// @brief The most results that are kept at once. When the cache is full, expired results are
+    /// dropped first, and then the results closest to expiring.
+    size_t max_entries = 1024;
+};
+
+/// @brief A cache of name resolution results, keyed on hostname and service, for callers that
+/// resolve the same few names over and over. Safe to use from several threads at once; lookups of
+/// cached results only share a lock with one another.
+class resolver_cache {
+   public:
+    /// @brief Create an empty resolver cache.
+    /// @param config Options used to customize the behavior of this cache.
+    explicit resolver_cache(const resolver_cache_config &config = resolver_cache_config());
+
+    // Disable copies and moves --------------------------------------------------------------------
+
+    resolver_cache(const resolver_cache &other)             = delete;
+    resolver_cache &operator=(const resolver_cache &other)  = delete;
+    resolver_cache(const resolver_cache &&other)            = delete;
+    resolver_cache &operator=(const resolver_cache &&other) = delete;
+
+    // ---------------------------------------------------------------------------------------------
+
+    /// @brief Return the result of name resolution for the given hostname and service, resolving
+    /// them only if no unexpired result is cached.
+    /// @param hostname The IP (v4 or v6) address of the desired host, or their canonical name.
+    /// @param service The name of the desired service or its corresponding port number, in string
+    /// form.
+    /// @return The result of name resolution for the given hostname and service.
+    resolve_result resolve(const std::string &hostname, const std::string &service);
+
+    /// @brief Return the result of name resolution for the given hostname and service, resolving
+    /// them only if no unexpired result is cached.
+    /// @param hostname The IP (v4 or v6) address of the desired host, or their canonical name.
+    /// @param service The name of the desired service or its corresponding port number, in string
+    /// form.
+    /// @param ec An error_code that is set if an error occurs, including one that was cached.
+    /// @return The result of name resolution for the given hostname and service.
+    resolve_result resolve(
+        const std::string &hostname, const std::string &service, std::error_code &ec);
+
+    /// @brief Drop the cached result for the given hostname and service, if there is one.
+    /// @param hostname The hostname of the result to be dropped.
+    /// @param service The service of the result to be dropped.
+    void invalidate(const std::string &hostname, const std::string &service);
+
+    /// @brief Drop the cached results for the given hostname, for every service.
+    /// @param hostname The hostname of the results to be dropped.
+    void invalidate(const std::string &hostname);
+
+    /// @brief Drop every cached result.
+    void clear();
+
+    /// @brief Return the number of results cached, including any that have expired but have not
+    /// been dropped yet.
+    /// @return The number of results cached.
+    size_t size() const;
+
+    /// @brief Return the number of lookups answered from the cache.
+    /// @return The number of lookups answered from the cache.
+    uint64_t hits() const;
+
+    /// @brief Return the number of lookups that had to resolve the name.
+    /// @return The number of lookups that had to resolve the name.
+    uint64_t misses() const;
+
+   private:
+    using clock_type = std::chrono::steady_clock;
+    using key_type   = std::pair<std::string, std::string>;
+
+    struct entry {
+        resolve_result endpoints;
+        std::error_code ec;
+        clock_type::time_point expiry;
+    };
+
+    void make_room_(clock_type::time_point now);
+
+    resolver_cache_config config_;
+
+    mutable std::shared_mutex mutex_;
+    std::map<key_type, entry> entries_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace yonaa
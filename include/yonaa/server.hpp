@@ -1,14 +1,25 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "yonaa/acceptor.hpp"
+#include "yonaa/addresses.hpp"
 #include "yonaa/buffer.hpp"
 #include "yonaa/connection.hpp"
 #include "yonaa/detail/poll.hpp"
+#include "yonaa/detail/slot_map.hpp"
+#include "yonaa/detail/thread_pool.hpp"
+#include "yonaa/detail/wakeup.hpp"
 
 namespace yonaa {
 
@@ -21,13 +32,106 @@ struct client_info {
     connection conn;
     socket_type fd;
     bool is_connected = false;
+    std::shared_ptr<detail::strand> strand;  // Orders the client's handler calls across threads
+
+    // Data waiting for room in the client's socket. The first send_queue_offset bytes of the first
+    // buffer have already been sent, and send_queue_size bytes are left to send. Buffers are shared
+    // with every other client that the same message was sent to.
+    std::deque<shared_buffer> send_queue;
+    size_t send_queue_offset  = 0;
+    size_t send_queue_size    = 0;
+    bool is_send_queue_high   = false;
+    bool is_watching_writable = false;
+
+    // Data waiting for room in the send queue (see: send_queue_overflow_policy::block)
+    std::deque<std::pair<std::vector<shared_buffer>, std::shared_ptr<std::promise<void>>>>
+        blocked_sends;
+};
+
+/// @brief What a server does with a message for a client whose send queue is full.
+enum class send_queue_overflow_policy {
+    drop,        /// @brief Discard the message.
+    disconnect,  /// @brief Disconnect and remove the client.
+    block,  /// @brief Hold the message until the queue has room for it. Threads other than the
+            /// network and handler threads also wait for that before returning from the messaging
+            /// function. (The network and handler threads never wait, since the send queue may only
+            /// drain once they return.)
+};
+
+/// @brief The mechanisms that a server can use to wait for network activity.
+enum class poll_mechanism {
+    automatic,  /// @brief Use the best mechanism available on this system.
+    poll,       /// @brief Use poll(2). Every wait scans every socket that the reactor serves.
+    epoll,      /// @brief Use epoll(7), where only the sockets that are ready are returned.
+                /// Falls back to poll(2) where epoll is not available. (Linux only)
+};
+
+/// @brief Options used to customize the behavior of a server.
+struct server_config {
+    /// @brief The longest that the network thread may block while waiting for network activity. The
+    /// network thread is woken up as soon as a connection or data arrives, or when stop(),
+    /// remove_client() or one of the messaging functions is called from another thread, so this
+    /// only bounds how long an idle server sleeps. A negative value means no limit.
+    std::chrono::milliseconds max_wait = std::chrono::milliseconds(1000);
+
+    /// @brief The mechanism used to wait for network activity.
+    poll_mechanism mechanism = poll_mechanism::automatic;
+
+    /// @brief The local addresses to accept connections at, each resolved with the server's port.
+    /// Every reactor listens at all of them. The default, any_address, resolves to the unspecified
+    /// address of both IPv4 and IPv6 (where the host supports it), so that clients of either family
+    /// can connect.
+    std::vector<std::string> listen_addresses = {any_address};
+
+    /// @brief Options used to tune the listening socket of every reactor. When there are several
+    /// reactors, reuse_port is always used, and a nonnegative incoming_cpu is the CPU of the first
+    /// reactor, with each later reactor taking the next CPU.
+    acceptor_options listener_options;
+
+    /// @brief Options set on the socket of every client that connects. When quick_ack is used, it
+    /// is set again after every receive, since the kernel may leave quick ack mode on its own.
+    connection_options client_options;
+
+    /// @brief The number of network threads (reactors) to run. Each reactor owns its own listening
+    /// sockets, bound to the same port with SO_REUSEPORT so that the kernel spreads incoming
+    /// connections across them, and serves the clients that it accepts. Handlers may be called
+    /// concurrently from every reactor. Zero means one reactor per hardware thread.
+    size_t reactor_count = 1;
+
+    /// @brief The number of handler threads to run. When nonzero, the network threads only perform
+    /// I/O, and every handler call is handed to a pool of handler threads that steal work from one
+    /// another. The handler calls for a single client are still made one at a time, in the order
+    /// that the events occurred. Zero means that handlers are called on the network threads.
+    size_t handler_thread_count = 0;
+
+    /// @brief The number of handler calls that may be waiting for a handler thread. A network
+    /// thread that finds the queue full waits for space, which stops it from reading any more data
+    /// until the handler threads catch up. Only used when handler_thread_count is nonzero.
+    size_t handler_queue_depth = 1024;
+
+    /// @brief The number of bytes that may be queued for a single client whose socket is not
+    /// accepting data fast enough. Messages that do not fit are handled according to
+    /// overflow_policy. A single message larger than this is still queued if the queue is empty.
+    size_t send_queue_limit = 4 * 1024 * 1024;
+
+    /// @brief The number of queued bytes at which the send queue high watermark handler is called.
+    size_t send_queue_high_watermark = 1024 * 1024;
+
+    /// @brief The number of queued bytes at which the send queue low watermark handler is called,
+    /// once the high watermark has been reached.
+    size_t send_queue_low_watermark = 256 * 1024;
+
+    /// @brief What to do with a message for a client whose send queue is full.
+    send_queue_overflow_policy overflow_policy = send_queue_overflow_policy::disconnect;
 };
 
 class server final {
    public:
     /// @brief The signature for a callback function supplied to the server to be called when
-    /// incoming data is received from a particular client.
-    using data_receive_handler = std::function<void(client_id, const buffer &)>;
+    /// incoming data is received from a particular client. The view is only valid until the
+    /// handler returns, so handlers that need the data afterwards should copy it. (see:
+    /// buffer(buffer_view))
+    using data_receive_handler = std::function<void(client_id, buffer_view)>;
 
     /// @brief The signature for a callback function supplied to the server to be called when a
     /// client connects to the server.
@@ -37,10 +141,16 @@ class server final {
     /// client disconnects from the server.
     using client_disconnect_handler = std::function<void(client_id)>;
 
+    /// @brief The signature for a callback function supplied to the server to be called when the
+    /// amount of data queued for a client crosses one of the send queue watermarks. The second
+    /// argument is the number of bytes queued.
+    using send_queue_watermark_handler = std::function<void(client_id, size_t)>;
+
    public:
     /// @brief Create a server that will listen for incoming connections on the given port.
     /// @param port The port to listen for incoming connections on.
-    explicit server(uint16_t port);
+    /// @param config Options used to customize the behavior of this server.
+    explicit server(uint16_t port, const server_config &config = server_config());
 
     /// @brief Close this server.
     ~server();
@@ -54,16 +164,35 @@ class server final {
 
     // ---------------------------------------------------------------------------------------------
 
-    /// @brief Start the server's network thread.
+    /// @brief Start the server's network threads.
     void run();
 
-    /// @brief Request that the server stop its operation and join the network thread.
+    /// @brief Request that the server stop its operation and join the network threads.
     void stop();
 
     /// @brief Install a function for this server to call when it receives data from a client.
     /// @param handler The function to be called.
     void set_data_receive_handler(const data_receive_handler &handler);
 
+    /// @brief Install a function that takes its data as a const buffer &, as data receive handlers
+    /// did before they were given views. Every message is copied into a buffer before the function
+    /// is called, so handlers that don't keep the data should take a buffer_view instead.
+    /// @tparam Handler The type of the function, which must be callable with a client_id and a
+    /// const buffer &, but not with a buffer_view.
+    /// @param handler The function to be called.
+    template<
+        typename Handler,
+        std::enable_if_t<
+            std::is_invocable_v<Handler &, client_id, const buffer &> &&
+                !std::is_invocable_v<Handler &, client_id, buffer_view>,
+            int> = 0>
+    void set_data_receive_handler(Handler handler) {
+        set_data_receive_handler(
+            data_receive_handler([handler](client_id id, buffer_view data) mutable {
+                handler(id, buffer(data));
+            }));
+    }
+
     /// @brief Install a function for this server to call when a client connects to it.
     /// @param handler The function to be called.
     void set_client_connect_handler(const client_connect_handler &handler);
@@ -72,47 +201,134 @@ class server final {
     /// @param handler The function to be called.
     void set_client_disconnect_handler(const client_disconnect_handler &handler);
 
-    /// @brief Send data to a client.
+    /// @brief Install a function for this server to call when the data queued for a client grows
+    /// to server_config::send_queue_high_watermark bytes. Optional.
+    /// @param handler The function to be called.
+    void set_send_queue_high_watermark_handler(const send_queue_watermark_handler &handler);
+
+    /// @brief Install a function for this server to call when the data queued for a client shrinks
+    /// back to server_config::send_queue_low_watermark bytes. Optional.
+    /// @param handler The function to be called.
+    void set_send_queue_low_watermark_handler(const send_queue_watermark_handler &handler);
+
+    /// @brief Send data to a client. Whatever the client's socket cannot accept right away is
+    /// queued, and sent as the socket becomes writable. If called from outside of the network
+    /// thread that serves the client, the message is handed to that network thread and sent from
+    /// there.
+    /// @param msg The data to be sent. On the client's network thread, whatever the socket accepts
+    /// right away is sent straight from msg, and only the rest is copied. Elsewhere, all of it is
+    /// copied. Either way, msg is no longer used once this function returns.
+    /// @param client_id The id of the client to receive the message.
+    void message_client(buffer_view msg, client_id client_id);
+
+    /// @brief Send shared data to a client. (see: message_client(buffer_view, client_id)) The
+    /// data is queued by reference rather than copied, so the caller may keep sharing it.
     /// @param msg The data to be sent.
     /// @param client_id The id of the client to receive the message.
-    void message_client(const buffer &msg, client_id client_id);
+    void message_client(const shared_buffer &msg, client_id client_id);
+
+    /// @brief Send data held in several places to a client, as one message, without joining it
+    /// together first. (see: message_client(buffer_view, client_id))
+    /// @param msg The data to be sent, in order. It is sent or copied just like the data given to
+    /// message_client(buffer_view, client_id).
+    /// @param client_id The id of the client to receive the message.
+    void message_client(buffer_sequence msg, client_id client_id);
 
-    /// @brief Send data to all but (optionally) a single client.
+    /// @brief Send shared data held in several buffers to a client, as one message, without
+    /// joining or copying the buffers. (e.g. a per-client header followed by a shared body)
+    /// @param msg The data to be sent, in order.
+    /// @param client_id The id of the client to receive the message.
+    void message_client(const std::vector<shared_buffer> &msg, client_id client_id);
+
+    /// @brief Send data to all but (optionally) a single client. Clients served by other network
+    /// threads have the message handed to their network thread and sent from there.
+    /// @param msg The data to be sent. Clients served by the calling network thread are sent
+    /// whatever their sockets accept straight from msg, and only the rest is copied. Every client
+    /// that needs the whole message shares a single copy.
+    /// @param exclude_client_id If specified, the id of the client that this data should not be
+    /// sent to.
+    void message_all_clients(buffer_view msg, client_id exclude_client_id = 0);
+
+    /// @brief Send shared data to all but (optionally) a single client. (see:
+    /// message_all_clients(buffer_view, client_id)) Every client's send queue refers to the same
+    /// data, so the data is never copied, however many clients it is sent to.
     /// @param msg The data to be sent.
     /// @param exclude_client_id If specified, the id of the client that this data should not be
     /// sent to.
-    void message_all_clients(const buffer &msg, client_id exclude_client_id = 0);
+    void message_all_clients(const shared_buffer &msg, client_id exclude_client_id = 0);
 
     /// @brief Mark a client for disconnection and removal. (see: "kick", "boot", "kill")
     /// @param client_id The id of the client to be disconnected and removed.
     void remove_client(client_id client_id);
 
-    /// @brief Return false if the network thread is joined (or attempting to), and true otherwise.
-    /// @return False if the network thread is joined (or attempting to), and true otherwise.
+    /// @brief Return false if the network threads are joined (or attempting to), and true
+    /// otherwise.
+    /// @return False if the network threads are joined (or attempting to), and true otherwise.
     bool is_running() { return running_; };
 
    private:
-    void network_thread_function_();
-    void handle_incoming_connections_();
-    void handle_incoming_messages_();
-    void handle_disconnected_clients_();
-    client_info *client_info_from_id(client_id client_id);
-    client_info *client_info_from_native_socket(socket_type socket_fd);
+    /// @brief The state owned by a single network thread.
+    struct reactor {
+        explicit reactor(size_t index, const server_config &config);
+
+        size_t index;
+        std::thread thread;
+        std::atomic<std::thread::id> thread_id;
+
+        std::error_code ec;
+        buffer receive_buffer;  // Reused for every receive, so that receiving does not allocate
+        detail::slot_map<client_info> clients;
+        std::vector<client_id> client_ids_by_fd;      // Zero if the socket is not a client's
+        std::vector<client_id> disconnected_clients;  // Marked for removal, but not yet removed
+
+        acceptor listener;
+        detail::poll_group poller;
+        detail::wakeup_event wakeup;
+
+        std::mutex pending_tasks_mutex;
+        std::vector<std::function<void()>> pending_tasks;
+        bool is_stopped = false;  // Guarded by pending_tasks_mutex
+    };
+
+    void network_thread_function_(reactor &r);
+    void handle_pending_tasks_(reactor &r);
+    void handle_incoming_connections_(reactor &r);
+    void handle_incoming_messages_(reactor &r, const detail::socket_status_info &event);
+    void handle_disconnected_clients_(reactor &r);
+    void send_to_client_(
+        reactor &r,
+        const std::vector<shared_buffer> &msg,
+        client_id client_id,
+        const std::shared_ptr<std::promise<void>> &on_queued);
+    void send_views_to_client_(
+        reactor &r, buffer_sequence msg, client_id client_id, std::vector<shared_buffer> &copy);
+    size_t write_views_(reactor &r, client_info &client, buffer_sequence msg);
+    void queue_message_(reactor &r, client_info &client, const std::vector<shared_buffer> &msg);
+    void write_send_queue_(reactor &r, client_info &client);
+    void flush_send_queue_(reactor &r, client_info &client);
+    void update_send_queue_state_(reactor &r, client_info &client);
+    void message_reactor_clients_(
+        reactor &r, const std::vector<shared_buffer> &msg, client_id exclude_client_id);
+    reactor *reactor_from_id_(client_id client_id);
+    bool is_reactor_thread_(const reactor &r) const;
+    void post_(reactor &r, std::function<void()> task);
+    client_info *client_info_from_id(reactor &r, client_id client_id);
+    client_info *client_info_from_native_socket(reactor &r, socket_type socket_fd);
 
    private:
     uint16_t port_;
-    bool running_;
-    bool has_disconnected_clients_;
+    server_config config_;
+    std::atomic<bool> running_;
     std::error_code ec_;
-    std::vector<std::unique_ptr<client_info>> clients_;
 
     data_receive_handler on_data_receive_;
     client_connect_handler on_client_connect_;
     client_disconnect_handler on_client_disconnect_;
+    send_queue_watermark_handler on_send_queue_high_;
+    send_queue_watermark_handler on_send_queue_low_;
 
-    std::thread network_thread_;
-    acceptor acceptor_;
-    detail::poll_group poll_group_;
+    std::unique_ptr<detail::thread_pool> handler_pool_;
+    std::vector<std::unique_ptr<reactor>> reactors_;
 };
 
 }  // namespace yonaa
@@ -2,11 +2,15 @@
 
 #include "yonaa/acceptor.hpp"
 #include "yonaa/addresses.hpp"
+#include "yonaa/async_resolver.hpp"
 #include "yonaa/buffer.hpp"
+#include "yonaa/buffer_pool.hpp"
 #include "yonaa/client.hpp"
 #include "yonaa/connection.hpp"
+#include "yonaa/connector.hpp"
 #include "yonaa/endpoint.hpp"
 #include "yonaa/logging.hpp"
 #include "yonaa/resolve.hpp"
+#include "yonaa/resolver_cache.hpp"
 #include "yonaa/server.hpp"
 #include "yonaa/types.hpp"
@@ -1,16 +1,16 @@
 #include "yonaa/acceptor.hpp"
 
+#include <poll.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+
 #include "yonaa/detail/poll.hpp"
 #include "yonaa/detail/socket_ops.hpp"
 
 namespace yonaa {
 
-/// @brief The maximum number of connections that an acceptor may queue for accepting.
-static const uint64_t backlog_size = 128;
-
-acceptor::acceptor() : socket_(0) {}
+acceptor::acceptor() {}
 
 acceptor::~acceptor() {
     if (is_open()) close();
@@ -26,43 +26,69 @@ void acceptor::open(const resolve_result &local_endpoints, acceptor_config_mask
 
 void acceptor::open(
     const resolve_result &local_endpoints, std::error_code &ec, acceptor_config_mask cfg) {
+    acceptor_options options;
+    options.reuse_address = (bool)(cfg & acceptor_config::reuse_address);
+    options.reuse_port    = (bool)(cfg & acceptor_config::reuse_port);
+
+    open(local_endpoints, ec, options);
+}
+
+void acceptor::open(const resolve_result &local_endpoints, const acceptor_options &options) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    open(local_endpoints, ec, options);
+
+    if (ec) throw ec;
+}
+
+void acceptor::open(
+    const resolve_result &local_endpoints,
+    std::error_code &ec,
+    const acceptor_options &options) {
     if (local_endpoints.empty()) {
         // TODO(Caleb): Custom error categories?
         ec.assign(1, std::system_category());
         return;
     }
 
-    bool reuse_addr = (bool)(cfg & acceptor_config::reuse_address);
-    socket_type socket_fd =
-        detail::socket_ops::create_listening_socket(local_endpoints, backlog_size, reuse_addr);
+    std::vector<socket_type> socket_fds =
+        detail::socket_ops::create_listening_sockets(local_endpoints, options);
 
-    if (socket_fd == 0) {
+    if (socket_fds.empty()) {
         // TODO(Caleb): Custom error categories?
-        ec.assign(32, std::system_category());
+        ec.assign(errno, std::system_category());
         return;
     }
 
-    socket_         = socket_fd;
-    local_endpoint_ = detail::socket_ops::get_local_endpoint(socket_fd);
+    std::vector<endpoint> bound_endpoints;
+    for (socket_type socket_fd : socket_fds) {
+        bound_endpoints.push_back(detail::socket_ops::get_local_endpoint(socket_fd));
+    }
+
+    sockets_         = std::move(socket_fds);
+    local_endpoints_ = std::move(bound_endpoints);
 }
 
 void acceptor::close() {
     if (!is_open()) return;
 
-    detail::socket_ops::close_socket(socket_);
+    for (socket_type socket_fd : sockets_) detail::socket_ops::close_socket(socket_fd);
 
-    socket_         = 0;
-    local_endpoint_ = endpoint();
+    sockets_.clear();
+    local_endpoints_.clear();
+    next_socket_index_ = 0;
+    is_non_blocking_   = false;
 }
 
 bool acceptor::is_open() const {
-    // Note(Caleb): socket_ is only assigned after a connect(), so this is fine.
-    return socket_ != 0;
+    return !sockets_.empty();
 }
 
 bool acceptor::has_pending_connection() const {
-    detail::socket_status_mask socket_status = detail::poll_socket(socket_, 0);
-    return (socket_status & detail::socket_status::readable) != 0;
+    return std::any_of(sockets_.begin(), sockets_.end(), [](socket_type socket_fd) {
+        detail::socket_status_mask socket_status = detail::poll_socket(socket_fd, 0);
+        return (socket_status & detail::socket_status::readable) != 0;
+    });
 }
 
 connection acceptor::accept() const {
@@ -82,10 +108,26 @@ connection acceptor::accept(std::error_code &ec) const {
         return connection();
     }
 
+    // Wait for a connection at any of the local endpoints, unless there is only one to wait at
+    size_t socket_index = 0;
+    if (sockets_.size() > 1) {
+        std::vector<pollfd> pfds;
+        for (socket_type socket_fd : sockets_) pfds.push_back({socket_fd, POLLIN, 0});
+
+        if (::poll(pfds.data(), pfds.size(), -1) == -1) {
+            // TODO(Caleb): Custom error categories?
+            ec.assign(errno, std::system_category());
+            return connection();
+        }
+
+        while (pfds[socket_index].revents == 0) socket_index++;
+    }
+
     address_storage_type remote_addr;
     address_size_type remote_addr_size = sizeof(remote_addr);
 
-    int remote_socket_fd = ::accept(socket_, (address_type *)&remote_addr, &remote_addr_size);
+    int remote_socket_fd =
+        ::accept(sockets_[socket_index], (address_type *)&remote_addr, &remote_addr_size);
     if (remote_socket_fd == -1) {
         // TODO(Caleb): Custom error categories?
         ec.assign(errno, std::system_category());
@@ -93,12 +135,111 @@ connection acceptor::accept(std::error_code &ec) const {
     }
 
     auto remote_endpoint = endpoint::from_native_address(
-        local_endpoint_.protocol(), (address_type *)&remote_addr, remote_addr_size);
+        local_endpoints_[socket_index].protocol(), (address_type *)&remote_addr, remote_addr_size);
     return connection::from_native_socket(remote_socket_fd, remote_endpoint);
 }
 
+std::vector<connection> acceptor::accept_batch(size_t max_connections) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    auto connections = accept_batch(max_connections, ec);
+
+    // Note: Throwing would close the connections that were accepted before the error, so the error
+    // is only thrown if there are none. An error that persists is thrown by the next call.
+    if (ec && connections.empty()) throw ec;
+
+    return connections;
+}
+
+std::vector<connection> acceptor::accept_batch(size_t max_connections, std::error_code &ec) {
+    std::vector<connection> connections;
+
+    if (!is_open()) {
+        // TODO(Caleb): Custom error categories?
+        ec.assign(1, std::system_category());
+        return connections;
+    }
+
+    if (!is_non_blocking_) {
+        for (socket_type socket_fd : sockets_) {
+            if (!detail::socket_ops::set_non_blocking(socket_fd, true)) {
+                // TODO(Caleb): Custom error categories?
+                ec.assign(errno, std::system_category());
+                return connections;
+            }
+        }
+        is_non_blocking_ = true;
+    }
+
+    // Start from a different socket each time, so that a busy one cannot keep the rest waiting
+    size_t first_socket_index = next_socket_index_;
+    next_socket_index_        = (next_socket_index_ + 1) % sockets_.size();
+
+    for (size_t i = 0; i < sockets_.size(); i++) {
+        if (connections.size() >= max_connections || ec) break;
+
+        size_t socket_index = (first_socket_index + i) % sockets_.size();
+        accept_pending_(socket_index, max_connections, connections, ec);
+    }
+
+    return connections;
+}
+
+socket_type acceptor::native_socket() const {
+    return sockets_.empty() ? 0 : sockets_.front();
+}
+
+const std::vector<socket_type> &acceptor::native_sockets() const {
+    return sockets_;
+}
+
 endpoint acceptor::local_endpoint() const {
-    return local_endpoint_;
+    return local_endpoints_.empty() ? endpoint() : local_endpoints_.front();
+}
+
+const std::vector<endpoint> &acceptor::local_endpoints() const {
+    return local_endpoints_;
+}
+
+/// @brief Accept the connections pending on one of this acceptor's sockets without blocking, until
+/// there are max_connections in total or none are left.
+/// @param socket_index The index of the socket to accept connections from.
+/// @param max_connections The most connections that connections may hold afterwards.
+/// @param connections The connections accepted so far, which the new ones are appended to.
+/// @param ec An error_code that is set if an error occurs.
+void acceptor::accept_pending_(
+    size_t socket_index,
+    size_t max_connections,
+    std::vector<connection> &connections,
+    std::error_code &ec) {
+    while (connections.size() < max_connections) {
+        address_storage_type remote_addr;
+        address_size_type remote_addr_size = sizeof(remote_addr);
+
+        int remote_socket_fd = ::accept4(
+            sockets_[socket_index],
+            (address_type *)&remote_addr,
+            &remote_addr_size,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (remote_socket_fd == -1) {
+            // A connection that was reset while it waited is simply skipped
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+
+            // No more connections are pending
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+
+            // TODO(Caleb): Custom error categories?
+            ec.assign(errno, std::system_category());
+            break;
+        }
+
+        auto remote_endpoint = endpoint::from_native_address(
+            local_endpoints_[socket_index].protocol(),
+            (address_type *)&remote_addr,
+            remote_addr_size);
+        connections.push_back(connection::from_native_socket(remote_socket_fd, remote_endpoint));
+    }
 }
 
 }  // namespace yonaa
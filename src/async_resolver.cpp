@@ -0,0 +1,199 @@
+#include "yonaa/async_resolver.hpp"
+
+#include <utility>
+
+namespace yonaa {
+
+async_resolver::async_resolver(const async_resolver_config &config) : config_(config) {
+    size_t thread_count = (config_.thread_count > 0) ? config_.thread_count : 1;
+    for (size_t i = 0; i < thread_count; i++) {
+        threads_.emplace_back(&async_resolver::worker_function_, this);
+    }
+
+    timer_thread_ = std::thread(&async_resolver::timer_function_, this);
+}
+
+async_resolver::~async_resolver() {
+    std::map<resolve_request_id, request> canceled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        canceled.swap(requests_);
+        queue_.clear();
+    }
+    work_available_.notify_all();
+    deadlines_changed_.notify_all();
+
+    for (auto &[id, r] : canceled) {
+        complete_(std::move(r), {}, std::make_error_code(std::errc::operation_canceled));
+    }
+
+    for (auto &thread : threads_) thread.join();
+    timer_thread_.join();
+}
+
+resolve_request_id async_resolver::async_resolve(
+    const std::string &hostname, const std::string &service, resolve_handler handler) {
+    return async_resolve(hostname, service, std::move(handler), config_.default_timeout);
+}
+
+resolve_request_id async_resolver::async_resolve(
+    const std::string &hostname,
+    const std::string &service,
+    resolve_handler handler,
+    std::chrono::milliseconds timeout,
+    executor handler_executor) {
+    request r;
+    r.hostname         = hostname;
+    r.service          = service;
+    r.handler          = std::move(handler);
+    r.handler_executor = std::move(handler_executor);
+    r.has_deadline     = timeout.count() > 0;
+    r.deadline         = clock_type::now() + timeout;
+
+    resolve_request_id id;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        id = next_id_++;
+
+        if (stopping_ || requests_.size() >= config_.max_pending_requests) {
+            lock.unlock();
+            complete_(
+                std::move(r), {}, std::make_error_code(std::errc::resource_unavailable_try_again));
+            return id;
+        }
+
+        requests_.emplace(id, std::move(r));
+        queue_.push_back(id);
+    }
+    work_available_.notify_one();
+    if (timeout.count() > 0) deadlines_changed_.notify_one();
+
+    return id;
+}
+
+bool async_resolver::cancel(resolve_request_id id) {
+    request r;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = requests_.find(id);
+        if (it == requests_.end()) return false;
+
+        r = std::move(it->second);
+        requests_.erase(it);
+    }
+
+    // Note: The id is left in the queue, and skipped by the worker that takes it.
+    complete_(std::move(r), {}, std::make_error_code(std::errc::operation_canceled));
+    return true;
+}
+
+size_t async_resolver::pending_requests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_.size();
+}
+
+/// @brief Resolve queued requests until this resolver stops.
+void async_resolver::worker_function_() {
+    while (true) {
+        resolve_request_id id;
+        std::string hostname;
+        std::string service;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_available_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+
+            id = queue_.front();
+            queue_.pop_front();
+
+            // Skip requests that were canceled or timed out while they waited
+            auto it = requests_.find(id);
+            if (it == requests_.end()) continue;
+
+            hostname = it->second.hostname;
+            service  = it->second.service;
+        }
+
+        std::error_code ec;
+        resolve_result result = config_.cache ? config_.cache->resolve(hostname, service, ec)
+                                              : resolve(hostname, service, ec);
+
+        request r;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // The request may have been canceled or timed out while it was being resolved
+            auto it = requests_.find(id);
+            if (it == requests_.end()) continue;
+
+            r = std::move(it->second);
+            requests_.erase(it);
+        }
+
+        complete_(std::move(r), std::move(result), ec);
+    }
+}
+
+/// @brief Time out requests as their deadlines pass, until this resolver stops.
+void async_resolver::timer_function_() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopping_) {
+        auto now = clock_type::now();
+
+        // Take the requests whose deadlines have passed, and find the next deadline
+        std::vector<request> expired;
+        bool has_next_deadline = false;
+        clock_type::time_point next_deadline;
+
+        for (auto it = requests_.begin(); it != requests_.end();) {
+            const request &r = it->second;
+            if (!r.has_deadline) {
+                it++;
+            } else if (r.deadline <= now) {
+                expired.push_back(std::move(it->second));
+                it = requests_.erase(it);
+            } else {
+                if (!has_next_deadline || r.deadline < next_deadline) next_deadline = r.deadline;
+                has_next_deadline = true;
+                it++;
+            }
+        }
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (request &r : expired) {
+                complete_(std::move(r), {}, std::make_error_code(std::errc::timed_out));
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (has_next_deadline) {
+            deadlines_changed_.wait_until(lock, next_deadline);
+        } else {
+            deadlines_changed_.wait(lock);
+        }
+    }
+}
+
+/// @brief Call the handler of a finished request, through its executor if it has one.
+/// @param r The finished request.
+/// @param result The result of the request.
+/// @param ec The error that the request finished with, if any.
+void async_resolver::complete_(request &&r, resolve_result result, std::error_code ec) {
+    if (!r.handler) return;
+
+    if (r.handler_executor) {
+        r.handler_executor(
+            [handler = std::move(r.handler), result = std::move(result), ec]() mutable {
+                handler(std::move(result), ec);
+            });
+    } else {
+        r.handler(std::move(result), ec);
+    }
+}
+
+}  // namespace yonaa
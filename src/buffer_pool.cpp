@@ -0,0 +1,326 @@
+#include "yonaa/buffer_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace yonaa {
+
+namespace {
+
+/// @brief The smallest size class, as a power of two. (64 bytes)
+constexpr size_t min_class_bits = 6;
+
+/// @brief The number of size classes. (64 bytes to 64 KiB)
+constexpr size_t class_count = 11;
+
+/// @brief The largest allocation that the pool serves.
+constexpr size_t max_class_size = (size_t)1 << (min_class_bits + class_count - 1);
+
+/// @brief The most bytes that a thread caches for a single size class.
+constexpr size_t max_cached_class_bytes = 64 * 1024;
+
+/// @brief The most blocks that a thread caches for a single size class.
+constexpr size_t max_cached_class_blocks = 64;
+
+/// @brief The default limit on the bytes held by the shared store.
+constexpr size_t default_max_bytes_held = 64 * 1024 * 1024;
+
+size_t class_size(size_t size_class) {
+    return (size_t)1 << (min_class_bits + size_class);
+}
+
+size_t class_capacity(size_t size_class) {
+    size_t capacity = max_cached_class_bytes / class_size(size_class);
+    return std::clamp<size_t>(capacity, 4, max_cached_class_blocks);
+}
+
+/// @brief The free blocks of a single thread. Only the owning thread touches the blocks, but the
+/// counters are also read by get_buffer_pool_stats().
+struct thread_cache {
+    std::vector<void *> blocks[class_count];
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<size_t> bytes_held{0};
+};
+
+/// @brief The free blocks of a single size class in the shared store.
+struct shared_class {
+    std::mutex mutex;
+    std::vector<void *> blocks;
+};
+
+/// @brief The state shared by every thread.
+struct pool_state {
+    shared_class classes[class_count];
+    std::atomic<size_t> bytes_held{0};
+    std::atomic<size_t> max_bytes_held{default_max_bytes_held};
+
+    std::mutex caches_mutex;
+    std::vector<thread_cache *> caches;
+    uint64_t retired_hits   = 0;  // Counted by threads that have since exited
+    uint64_t retired_misses = 0;
+};
+
+// Note: The state is never destroyed, since buffers with static storage duration may release
+// their storage after every other static object is gone.
+pool_state &state() {
+    static pool_state *s = new pool_state();
+    return *s;
+}
+
+// Note: These are trivially destructible, so they can still be read while (and after) the
+// thread's cache is retired.
+thread_local thread_cache *current_cache = nullptr;
+thread_local bool is_cache_retired       = false;
+
+/// @brief Move a block into the shared store, or release it to the system allocator if the store
+/// is full (or cannot grow).
+void release_shared(size_t size_class, void *block) noexcept {
+    pool_state &s = state();
+    size_t size   = class_size(size_class);
+
+    // Note: The room is reserved before the block is stored, so that threads releasing blocks at
+    // the same time cannot overshoot the limit together.
+    size_t bytes_held = s.bytes_held.fetch_add(size, std::memory_order_relaxed);
+    if (bytes_held + size > s.max_bytes_held.load(std::memory_order_relaxed)) {
+        s.bytes_held.fetch_sub(size, std::memory_order_relaxed);
+        ::operator delete(block);
+        return;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(s.classes[size_class].mutex);
+        s.classes[size_class].blocks.push_back(block);
+    } catch (...) {
+        s.bytes_held.fetch_sub(size, std::memory_order_relaxed);
+        ::operator delete(block);
+    }
+}
+
+/// @brief Move up to count blocks of a thread's cache into the shared store.
+void spill(thread_cache &cache, size_t size_class, size_t count) noexcept {
+    auto &blocks = cache.blocks[size_class];
+    count        = std::min(count, blocks.size());
+
+    for (size_t i = 0; i < count; i++) {
+        release_shared(size_class, blocks.back());
+        blocks.pop_back();
+    }
+    cache.bytes_held.fetch_sub(count * class_size(size_class), std::memory_order_relaxed);
+}
+
+void retire(thread_cache *cache) {
+    for (size_t size_class = 0; size_class < class_count; size_class++) {
+        spill(*cache, size_class, cache->blocks[size_class].size());
+    }
+
+    pool_state &s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.caches_mutex);
+        s.retired_hits += cache->hits.load(std::memory_order_relaxed);
+        s.retired_misses += cache->misses.load(std::memory_order_relaxed);
+        s.caches.erase(std::find(s.caches.begin(), s.caches.end(), cache));
+    }
+
+    delete cache;
+}
+
+/// @brief Retires the thread's cache when the thread exits.
+struct thread_cache_owner {
+    thread_cache *cache = nullptr;
+
+    ~thread_cache_owner() {
+        if (cache) retire(cache);
+        current_cache    = nullptr;
+        is_cache_retired = true;
+    }
+};
+
+thread_local thread_cache_owner cache_owner;
+
+/// @brief Return the calling thread's cache, or nullptr if the thread is exiting or its cache
+/// cannot be allocated.
+thread_cache *get_thread_cache() noexcept {
+    if (current_cache || is_cache_retired) return current_cache;
+
+    // Note: Deallocations get here too, and must not throw. A thread whose cache cannot be
+    // allocated goes without one, and tries again on its next call.
+    auto *cache = new (std::nothrow) thread_cache();
+    if (!cache) return nullptr;
+
+    // Note: Each class is reserved in full up front, and spilled before it outgrows that, so
+    // caching a block never allocates.
+    try {
+        for (size_t size_class = 0; size_class < class_count; size_class++) {
+            cache->blocks[size_class].reserve(class_capacity(size_class));
+        }
+
+        pool_state &s = state();
+        std::lock_guard<std::mutex> lock(s.caches_mutex);
+        s.caches.push_back(cache);
+    } catch (...) {
+        delete cache;
+        return nullptr;
+    }
+
+    cache_owner.cache = cache;
+    current_cache     = cache;
+    return cache;
+}
+
+}  // namespace
+
+buffer_pool_stats get_buffer_pool_stats() {
+    pool_state &s = state();
+    buffer_pool_stats stats;
+
+    std::lock_guard<std::mutex> lock(s.caches_mutex);
+    stats.hits           = s.retired_hits;
+    stats.misses         = s.retired_misses;
+    stats.bytes_held     = s.bytes_held.load(std::memory_order_relaxed);
+    stats.max_bytes_held = s.max_bytes_held.load(std::memory_order_relaxed);
+
+    for (const thread_cache *cache : s.caches) {
+        stats.hits += cache->hits.load(std::memory_order_relaxed);
+        stats.misses += cache->misses.load(std::memory_order_relaxed);
+        stats.bytes_held += cache->bytes_held.load(std::memory_order_relaxed);
+    }
+
+    return stats;
+}
+
+void set_buffer_pool_limit(size_t max_bytes_held) {
+    state().max_bytes_held.store(max_bytes_held, std::memory_order_relaxed);
+}
+
+void trim_buffer_pool() {
+    if (thread_cache *cache = get_thread_cache()) {
+        for (size_t size_class = 0; size_class < class_count; size_class++) {
+            auto &blocks = cache->blocks[size_class];
+            for (void *block : blocks) ::operator delete(block);
+
+            cache->bytes_held.fetch_sub(
+                blocks.size() * class_size(size_class), std::memory_order_relaxed);
+            blocks.clear();
+        }
+    }
+
+    pool_state &s = state();
+    for (size_t size_class = 0; size_class < class_count; size_class++) {
+        std::vector<void *> blocks;
+        {
+            std::lock_guard<std::mutex> lock(s.classes[size_class].mutex);
+            blocks.swap(s.classes[size_class].blocks);
+        }
+
+        for (void *block : blocks) ::operator delete(block);
+        s.bytes_held.fetch_sub(blocks.size() * class_size(size_class), std::memory_order_relaxed);
+    }
+}
+
+namespace detail {
+
+#if defined(YONAA_ENABLE_BUFFER_POOL)
+
+static size_t class_of(size_t size) {
+    size_t size_class = 0;
+    while (class_size(size_class) < size) size_class++;
+
+    return size_class;
+}
+
+static void count(std::atomic<uint64_t> &counter) {
+    // Note: Only the owning thread writes a cache's counters, so there is no need for a locked
+    // increment.
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void *allocate_pooled(size_t size) {
+    thread_cache *cache = get_thread_cache();
+
+    if (size > max_class_size) {
+        if (cache) count(cache->misses);
+        return ::operator new(size);
+    }
+
+    size_t size_class = class_of(size);
+
+    if (!cache) return ::operator new(class_size(size_class));
+
+    // Serve the allocation from the thread's own cache...
+    auto &blocks = cache->blocks[size_class];
+    if (blocks.empty()) {
+        // ... after refilling half of it from the shared store, if need be
+        pool_state &s   = state();
+        size_t refilled = 0;
+        {
+            std::lock_guard<std::mutex> lock(s.classes[size_class].mutex);
+            auto &shared = s.classes[size_class].blocks;
+
+            refilled = std::min(shared.size(), class_capacity(size_class) / 2);
+            blocks.insert(blocks.end(), shared.end() - refilled, shared.end());
+            shared.resize(shared.size() - refilled);
+        }
+
+        size_t refilled_bytes = refilled * class_size(size_class);
+        s.bytes_held.fetch_sub(refilled_bytes, std::memory_order_relaxed);
+        cache->bytes_held.fetch_add(refilled_bytes, std::memory_order_relaxed);
+    }
+
+    if (blocks.empty()) {
+        count(cache->misses);
+        return ::operator new(class_size(size_class));
+    }
+
+    void *block = blocks.back();
+    blocks.pop_back();
+
+    cache->bytes_held.fetch_sub(class_size(size_class), std::memory_order_relaxed);
+    count(cache->hits);
+    return block;
+}
+
+void deallocate_pooled(void *storage, size_t size) noexcept {
+    if (!storage) return;
+
+    if (size > max_class_size) {
+        ::operator delete(storage);
+        return;
+    }
+
+    size_t size_class   = class_of(size);
+    thread_cache *cache = get_thread_cache();
+
+    if (!cache) {
+        release_shared(size_class, storage);
+        return;
+    }
+
+    // Make room by spilling half of a full cache into the shared store
+    auto &blocks = cache->blocks[size_class];
+    if (blocks.size() >= class_capacity(size_class)) {
+        spill(*cache, size_class, blocks.size() / 2);
+    }
+
+    blocks.push_back(storage);
+    cache->bytes_held.fetch_add(class_size(size_class), std::memory_order_relaxed);
+}
+
+#else
+
+void *allocate_pooled(size_t size) {
+    return ::operator new(size);
+}
+
+void deallocate_pooled(void *storage, size_t) noexcept {
+    ::operator delete(storage);
+}
+
+#endif
+
+}  // namespace detail
+
+}  // namespace yonaa
@@ -1,10 +1,19 @@
 #include "yonaa/client.hpp"
 
+#include <cstring>
+
+#include "yonaa/detail/poll.hpp"
 #include "yonaa/logging.hpp"
 #include "yonaa/resolve.hpp"
 
 namespace yonaa {
+
+/// @brief The most bytes that are received from the server at once.
+static const size_t max_receive_size = 8192;
+
 client::~client() {
+    disconnect();
+
     if (network_thread_.joinable()) {
         YONAA_INTERNAL_TRACE("Joining the network thread");
         network_thread_.join();
@@ -23,8 +32,13 @@ void client::set_data_receive_handler(const data_receive_handler &handler) {
     on_data_receive_ = handler;
 }
 
+void client::set_connection_options(const connection_options &options) {
+    connection_options_ = options;
+}
+
 void client::connect(const std::string &hostname, const std::string &service) {
     server_addr_ = {hostname, service};
+    running_     = true;
 
     YONAA_INTERNAL_TRACE("Spawning network thread");
     network_thread_ = std::thread(&client::network_thread_function_, this);
@@ -32,22 +46,54 @@ void client::connect(const std::string &hostname, const std::string &service) {
 
 void client::disconnect() {
     running_ = false;
+    wakeup_.notify();
     YONAA_INTERNAL_TRACE("Stop signal received");
 }
 
-void client::send_message(const buffer &msg) {
-    conn_.send(msg, ec_);
+void client::send_message(buffer_view msg) {
+    send_message(buffer_sequence{msg});
+}
+
+void client::send_message(buffer_sequence msg) {
+    if (msg.total_size() == 0) return;
+
+    if (std::this_thread::get_id() == network_thread_id_.load()) {
+        // Messages handed over by other threads go first, so that they keep their place in line
+        std::error_code ec;
+        if (send_pending_messages_()) conn_.send(msg, ec);
+
+        // If the send fails, assume we have been disconnected
+        if (ec || ec_) { disconnect(); }
+        return;
+    }
+
+    // Note: The parts are joined while they are copied, since they are copied either way.
+    buffer data;
+    data.resize_uninitialized(msg.total_size());
+
+    size_t offset = 0;
+    for (size_t i = 0; i < msg.size(); i++) {
+        if (msg[i].empty()) continue;
+
+        std::memcpy(data.data() + offset, msg[i].data(), msg[i].size());
+        offset += msg[i].size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pending_sends_mutex_);
+        pending_sends_.push_back(std::move(data));
+    }
 
-    // If the send fails, assume we have been disconnected
-    if (ec_) { on_disconnect_(); }
+    wakeup_.notify();
 }
 
 bool client::is_connected() const {
-    return conn_.is_connected();
+    return is_connected_;
 }
 
 void client::network_thread_function_() {
     YONAA_INTERNAL_TRACE("Network thread started");
+    network_thread_id_ = std::this_thread::get_id();
 
     auto remote_endpoints = resolve(server_addr_.hostname, server_addr_.service, ec_);
     if (ec_) {
@@ -61,38 +107,80 @@ void client::network_thread_function_() {
         YONAA_INTERNAL_ERROR("Unable to open a connection to the remote");
         std::exit(EXIT_FAILURE);
     }
+
+    conn_.set_options(connection_options_, ec_);
+    if (ec_) {
+        YONAA_INTERNAL_WARN("Unable to set the socket options of the connection");
+        ec_.clear();
+    }
+    is_connected_ = true;
+
     on_connect_();
 
-    while (running_) {
-        handle_incoming_messages_();
+    // Sleep until data arrives or another thread wakes this one up
+    detail::poll_group poller(detail::socket_status::readable);
+    poller.add_socket(conn_.native_socket());
+    poller.add_socket(wakeup_.native_handle());
 
-        // TODO(Caleb): Make this sleep configurable
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    while (running_) {
+        for (const auto &event : poller.poll(-1)) {
+            if (event.socket_fd == wakeup_.native_handle()) {
+                wakeup_.reset();
+                if (!send_pending_messages_()) running_ = false;
+            } else if (!handle_incoming_messages_()) {
+                running_ = false;
+            }
+        }
     }
 
+    poller.remove_socket(wakeup_.native_handle());
+    poller.remove_socket(conn_.native_socket());
+
+    is_connected_ = false;
     conn_.disconnect();
     on_disconnect_();
 
     YONAA_INTERNAL_TRACE("Network thread ended");
 }
 
-void client::handle_incoming_messages_() {
-    if (!conn_.is_connected()) {
-        on_disconnect_();
-        return;
+/// @brief Receive the data waiting on the connection and pass it to the data receive handler.
+/// @return False if the server has disconnected, and true otherwise.
+bool client::handle_incoming_messages_() {
+    if (!conn_.is_connected()) return false;
+
+    receive_buffer_.resize_uninitialized(max_receive_size);
+    size_t bytes_received = conn_.receive_into(receive_buffer_, ec_);
+
+    if (ec_ || (bytes_received == 0)) {
+        YONAA_INTERNAL_DEBUG("Disconnect message received");
+        return false;
     }
 
-    if (conn_.has_data_available()) { return; }
+    receive_buffer_.resize_uninitialized(bytes_received);
+    on_data_receive_(receive_buffer_);
 
-    buffer data = conn_.receive(ec_);
+    return true;
+}
 
-    if (ec_ || (data.size() == 0)) {
-        YONAA_INTERNAL_DEBUG("Disconnect message received");
-        on_disconnect_();
-        return;
+/// @brief Send the messages that other threads have handed to the network thread, in the order
+/// that they were handed over, gathering them into as few writes as possible.
+/// @return False if the send failed, and true otherwise.
+bool client::send_pending_messages_() {
+    std::vector<buffer> messages;
+    {
+        std::lock_guard<std::mutex> lock(pending_sends_mutex_);
+        messages.swap(pending_sends_);
+    }
+
+    if (messages.empty()) return true;
+
+    conn_.send(buffer_sequence(messages), ec_);
+    if (ec_) {
+        YONAA_INTERNAL_DEBUG("Unable to send to the server");
+        return false;
     }
 
-    on_data_receive_(data);
+    return true;
 }
 
 }  // namespace yonaa
@@ -8,12 +8,45 @@ namespace yonaa {
 /// @brief The maximum size of a buffer to be used for message transceiving.
 static const size_t max_buffer_size = 8192;
 
+/// @brief Return iovecs that describe the data referred to by a sequence of views, less the first
+/// offset bytes. Empty views are skipped.
+/// @param data The views to be described.
+/// @param offset The number of bytes at the start of the sequence to skip.
+/// @return Iovecs that describe the data referred to by the views.
+static std::vector<iovec> make_iovecs(buffer_sequence data, size_t offset = 0) {
+    std::vector<iovec> iovecs;
+    iovecs.reserve(data.size());
+
+    for (size_t i = 0; i < data.size(); i++) {
+        buffer_view b = data[i];
+        if (offset >= b.size()) {
+            offset -= b.size();
+            continue;
+        }
+
+        iovecs.push_back({(void *)(b.data() + offset), b.size() - offset});
+        offset = 0;
+    }
+
+    return iovecs;
+}
+
+/// @brief Return the native flags for a call to send() or sendmsg().
+/// @param flags A bitfield of send_flags constants.
+/// @return The native flags for a call to send() or sendmsg().
+static int native_send_flags(send_flags_mask flags) {
+    int send_flags = 0;
+    send_flags |= (flags & send_flags::dont_route) ? MSG_DONTROUTE : 0;
+    send_flags |= (flags & send_flags::end_of_record) ? MSG_EOR : 0;
+
+    return send_flags;
+}
+
 connection::connection() : socket_(0) {}
 
 connection connection::from_native_socket(socket_type socket_fd, const endpoint &remote_endpoint) {
     connection conn;
     conn.socket_          = socket_fd;
-    conn.local_endpoint_  = detail::socket_ops::get_local_endpoint(socket_fd);
     conn.remote_endpoint_ = remote_endpoint;
 
     return conn;
@@ -28,13 +61,15 @@ connection::connection(connection &&other) {
 }
 
 connection &connection::operator=(connection &&other) {
-    socket_          = other.socket_;
-    local_endpoint_  = other.local_endpoint_;
-    remote_endpoint_ = other.remote_endpoint_;
+    socket_                  = other.socket_;
+    local_endpoint_          = other.local_endpoint_;
+    is_local_endpoint_known_ = other.is_local_endpoint_known_.load();
+    remote_endpoint_         = other.remote_endpoint_;
 
-    other.socket_          = 0;
-    other.local_endpoint_  = endpoint();
-    other.remote_endpoint_ = endpoint();
+    other.socket_                  = 0;
+    other.local_endpoint_          = endpoint();
+    other.is_local_endpoint_known_ = false;
+    other.remote_endpoint_         = endpoint();
 
     return *this;
 }
@@ -48,6 +83,38 @@ void connection::connect(const resolve_result &remote_endpoints) {
 }
 
 void connection::connect(const resolve_result &remote_endpoints, std::error_code &ec) {
+    connect(remote_endpoints, connect_options(), ec);
+}
+
+void connection::connect(const resolve_result &remote_endpoints, const connect_options &options) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    connect(remote_endpoints, options, ec);
+
+    if (ec) throw ec;
+}
+
+void connection::connect(
+    const resolve_result &remote_endpoints, std::chrono::milliseconds timeout) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    connect(remote_endpoints, timeout, ec);
+
+    if (ec) throw ec;
+}
+
+void connection::connect(
+    const resolve_result &remote_endpoints,
+    std::chrono::milliseconds timeout,
+    std::error_code &ec) {
+    connect_options options;
+    options.timeout = timeout;
+
+    connect(remote_endpoints, options, ec);
+}
+
+void connection::connect(
+    const resolve_result &remote_endpoints, const connect_options &options, std::error_code &ec) {
     if (remote_endpoints.empty()) {
         // TODO(Caleb): Custom error categories?
         ec.assign(1, std::system_category());
@@ -55,7 +122,7 @@ void connection::connect(const resolve_result &remote_endpoints, std::error_code
     }
 
     // Attempt to create a connected socket
-    int socket_fd = detail::socket_ops::create_connected_socket(remote_endpoints);
+    int socket_fd = detail::socket_ops::create_connected_socket(remote_endpoints, options);
 
     if (socket_fd == 0) {
         // TODO(Caleb): Custom error categories?
@@ -63,9 +130,10 @@ void connection::connect(const resolve_result &remote_endpoints, std::error_code
         return;
     }
 
-    socket_          = socket_fd;
-    local_endpoint_  = detail::socket_ops::get_local_endpoint(socket_);
-    remote_endpoint_ = detail::socket_ops::get_remote_endpoint(socket_);
+    socket_                  = socket_fd;
+    local_endpoint_          = detail::socket_ops::get_local_endpoint(socket_);
+    is_local_endpoint_known_ = true;
+    remote_endpoint_         = detail::socket_ops::get_remote_endpoint(socket_);
 }
 
 void connection::disconnect() {
@@ -73,12 +141,13 @@ void connection::disconnect() {
 
     detail::socket_ops::close_socket(socket_);
 
-    socket_          = 0;
-    local_endpoint_  = endpoint();
-    remote_endpoint_ = endpoint();
+    socket_                  = 0;
+    local_endpoint_          = endpoint();
+    is_local_endpoint_known_ = false;
+    remote_endpoint_         = endpoint();
 }
 
-void connection::send(const buffer &data, send_flags_mask flags) const {
+void connection::send(buffer_view data, send_flags_mask flags) const {
     // Delegate function call and throw if necessary
     std::error_code ec;
     send(data, ec, flags);
@@ -86,7 +155,7 @@ void connection::send(const buffer &data, send_flags_mask flags) const {
     if (ec) throw ec;
 }
 
-void connection::send(const buffer &data, std::error_code &ec, send_flags_mask flags) const {
+void connection::send(buffer_view data, std::error_code &ec, send_flags_mask flags) const {
     if (!is_connected() || data.size() == 0) {
         ec.assign(1, std::system_category());
         return;
@@ -95,10 +164,7 @@ void connection::send(const buffer &data, std::error_code &ec, send_flags_mask f
     const char *send_buffer = data.data();
     size_t send_buffer_size = data.size();
 
-    // Translate flags
-    int send_flags = 0;
-    send_flags |= (flags & send_flags::dont_route) ? MSG_DONTROUTE : 0;
-    send_flags |= (flags & send_flags::end_of_record) ? MSG_EOR : 0;
+    int send_flags = native_send_flags(flags);
 
     size_t bytes_sent = 0;
     while (bytes_sent < send_buffer_size) {
@@ -106,6 +172,14 @@ void connection::send(const buffer &data, std::error_code &ec, send_flags_mask f
             ::send(socket_, send_buffer + bytes_sent, send_buffer_size - bytes_sent, send_flags | MSG_NOSIGNAL);
 
         if (send_result == -1) {
+            if (errno == EINTR) continue;
+
+            // Wait for room in the send buffer of a non-blocking socket
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                (void)detail::poll_socket(socket_, -1, detail::socket_status::writable);
+                continue;
+            }
+
             // TODO(Caleb): Custom error categories?
             ec.assign(errno, std::system_category());
             return;
@@ -114,6 +188,116 @@ void connection::send(const buffer &data, std::error_code &ec, send_flags_mask f
     }
 }
 
+size_t connection::try_send(buffer_view data, size_t offset, send_flags_mask flags) const {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    size_t bytes_sent = try_send(data, offset, ec, flags);
+
+    if (ec) throw ec;
+
+    return bytes_sent;
+}
+
+size_t connection::try_send(
+    buffer_view data, size_t offset, std::error_code &ec, send_flags_mask flags) const {
+    if (!is_connected() || offset >= data.size()) {
+        ec.assign(1, std::system_category());
+        return 0;
+    }
+
+    int send_flags = native_send_flags(flags) | MSG_DONTWAIT | MSG_NOSIGNAL;
+
+    while (true) {
+        ssize_t send_result =
+            ::send(socket_, data.data() + offset, data.size() - offset, send_flags);
+
+        if (send_result >= 0) return (size_t)send_result;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+
+        // TODO(Caleb): Custom error categories?
+        ec.assign(errno, std::system_category());
+        return 0;
+    }
+}
+
+void connection::send(buffer_sequence data, send_flags_mask flags) const {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    send(data, ec, flags);
+
+    if (ec) throw ec;
+}
+
+void connection::send(buffer_sequence data, std::error_code &ec, send_flags_mask flags) const {
+    std::vector<iovec> iovecs = make_iovecs(data);
+
+    if (!is_connected() || iovecs.empty()) {
+        ec.assign(1, std::system_category());
+        return;
+    }
+
+    iovec *next_iovec  = iovecs.data();
+    size_t iovec_count = iovecs.size();
+    while (iovec_count > 0) {
+        ssize_t send_result = detail::socket_ops::send_iovecs(
+            socket_, next_iovec, iovec_count, native_send_flags(flags) | MSG_NOSIGNAL);
+
+        if (send_result == -1) {
+            if (errno == EINTR) continue;
+
+            // Wait for room in the send buffer of a non-blocking socket
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                (void)detail::poll_socket(socket_, -1, detail::socket_status::writable);
+                continue;
+            }
+
+            // TODO(Caleb): Custom error categories?
+            ec.assign(errno, std::system_category());
+            return;
+        }
+
+        // Resume a partial send from the first byte that was not sent
+        detail::socket_ops::advance_iovecs(next_iovec, iovec_count, (size_t)send_result);
+    }
+}
+
+size_t connection::try_send(buffer_sequence data, size_t offset, send_flags_mask flags) const {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    size_t bytes_sent = try_send(data, offset, ec, flags);
+
+    if (ec) throw ec;
+
+    return bytes_sent;
+}
+
+size_t connection::try_send(
+    buffer_sequence data, size_t offset, std::error_code &ec, send_flags_mask flags) const {
+    std::vector<iovec> iovecs = make_iovecs(data, offset);
+
+    if (!is_connected() || iovecs.empty()) {
+        ec.assign(1, std::system_category());
+        return 0;
+    }
+
+    while (true) {
+        ssize_t send_result = detail::socket_ops::send_iovecs(
+            socket_,
+            iovecs.data(),
+            iovecs.size(),
+            native_send_flags(flags) | MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (send_result >= 0) return (size_t)send_result;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+
+        // TODO(Caleb): Custom error categories?
+        ec.assign(errno, std::system_category());
+        return 0;
+    }
+}
+
 buffer connection::receive(receive_flags_mask flags) {
     // Delegate function call and throw if necessary
     std::error_code ec;
@@ -142,35 +326,104 @@ buffer connection::receive(std::error_code &ec, receive_flags_mask flags) {
 }
 
 buffer connection::receive(size_t size, std::error_code &ec, receive_flags_mask flags) {
+    buffer receive_buffer;
+    receive_buffer.resize_uninitialized(size);
+
+    size_t bytes_received = receive_into(receive_buffer, ec, flags);
+
+    receive_buffer.resize_uninitialized(bytes_received);
+    return receive_buffer;
+}
+
+size_t connection::receive_into(char *data, size_t size, receive_flags_mask flags) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    size_t bytes_received = receive_into(data, size, ec, flags);
+
+    if (ec) throw ec;
+
+    return bytes_received;
+}
+
+size_t connection::receive_into(
+    char *data, size_t size, std::error_code &ec, receive_flags_mask flags) {
     if (!is_connected() || size == 0) {
         ec.assign(1, std::system_category());
-        return buffer();
+        return 0;
     }
 
-    buffer receive_buffer(size);
+    // Translate flags
+    int recv_flags = 0;
+    recv_flags |= (flags & receive_flags::peek) ? MSG_PEEK : 0;
+
+    ssize_t recv_result = ::recv(socket_, data, size, recv_flags);
+
+    if (recv_result == 0) {  // The remote endpoint is disconnected.
+        disconnect();
+
+        // TODO(Caleb): Custom error categories?
+        ec.assign(errno, std::system_category());
+        return 0;
+    }
+
+    if (recv_result == -1) {
+        // TODO(Caleb): Custom error categories?
+        ec.assign(errno, std::system_category());
+        return 0;
+    }
+
+    return (size_t)recv_result;
+}
+
+size_t connection::receive_into(buffer &data, receive_flags_mask flags) {
+    return receive_into(data.data(), data.size(), flags);
+}
+
+size_t connection::receive_into(buffer &data, std::error_code &ec, receive_flags_mask flags) {
+    return receive_into(data.data(), data.size(), ec, flags);
+}
+
+size_t connection::receive(std::vector<buffer> &data, receive_flags_mask flags) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    size_t bytes_received = receive(data, ec, flags);
+
+    if (ec) throw ec;
+
+    return bytes_received;
+}
+
+size_t connection::receive(
+    std::vector<buffer> &data, std::error_code &ec, receive_flags_mask flags) {
+    std::vector<iovec> iovecs = make_iovecs(data);
+
+    if (!is_connected() || iovecs.empty()) {
+        ec.assign(1, std::system_category());
+        return 0;
+    }
 
     // Translate flags
     int recv_flags = 0;
     recv_flags |= (flags & receive_flags::peek) ? MSG_PEEK : 0;
 
-    int recv_result = ::recv(socket_, receive_buffer.data(), size, recv_flags);
+    ssize_t recv_result =
+        detail::socket_ops::receive_iovecs(socket_, iovecs.data(), iovecs.size(), recv_flags);
 
     if (recv_result == 0) {  // The remote endpoint is disconnected.
         disconnect();
 
         // TODO(Caleb): Custom error categories?
         ec.assign(errno, std::system_category());
-        return buffer();
+        return 0;
     }
 
     if (recv_result == -1) {
         // TODO(Caleb): Custom error categories?
         ec.assign(errno, std::system_category());
-        return buffer();
+        return 0;
     }
 
-    receive_buffer.resize(recv_result);
-    return receive_buffer;
+    return (size_t)recv_result;
 }
 
 bool connection::is_connected() const {
@@ -183,11 +436,69 @@ bool connection::has_data_available() const {
     return (bool)(status & detail::socket_status::readable);
 }
 
+void connection::set_options(const connection_options &options) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    set_options(options, ec);
+
+    if (ec) throw ec;
+}
+
+void connection::set_options(const connection_options &options, std::error_code &ec) {
+    if (!is_connected()) {
+        // TODO(Caleb): Custom error categories?
+        ec.assign(1, std::system_category());
+        return;
+    }
+
+    if (!detail::socket_ops::set_connection_options(socket_, options)) {
+        // TODO(Caleb): Custom error categories?
+        ec.assign(errno, std::system_category());
+    }
+}
+
+connection_options connection::options() const {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    auto options = this->options(ec);
+
+    if (ec) throw ec;
+
+    return options;
+}
+
+connection_options connection::options(std::error_code &ec) const {
+    connection_options options;
+
+    if (!is_connected()) {
+        // TODO(Caleb): Custom error categories?
+        ec.assign(1, std::system_category());
+        return options;
+    }
+
+    if (!detail::socket_ops::get_connection_options(socket_, options)) {
+        // TODO(Caleb): Custom error categories?
+        ec.assign(errno, std::system_category());
+    }
+
+    return options;
+}
+
 socket_type connection::native_socket() const {
     return socket_;
 }
 
 endpoint connection::local_endpoint() const {
+    if (is_connected() && !is_local_endpoint_known_.load(std::memory_order_acquire)) {
+        // Note: The flag is checked again under the lock so that only one thread looks the endpoint
+        // up, and the others wait for it rather than reading a half-written endpoint.
+        std::lock_guard<std::mutex> lock(local_endpoint_mutex_);
+        if (!is_local_endpoint_known_.load(std::memory_order_relaxed)) {
+            local_endpoint_ = detail::socket_ops::get_local_endpoint(socket_);
+            is_local_endpoint_known_.store(true, std::memory_order_release);
+        }
+    }
+
     return local_endpoint_;
 }
 endpoint connection::remote_endpoint() const {
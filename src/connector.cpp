@@ -0,0 +1,241 @@
+#include "yonaa/connector.hpp"
+
+#include <memory>
+#include <utility>
+
+#include "yonaa/detail/connect_race.hpp"
+#include "yonaa/detail/poll.hpp"
+#include "yonaa/detail/socket_ops.hpp"
+
+namespace yonaa {
+
+connector::connector(const connector_config &config) : config_(config) {
+    thread_ = std::thread(&connector::network_thread_function_, this);
+}
+
+connector::~connector() {
+    std::map<connect_request_id, request> canceled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        canceled.swap(submitted_);
+    }
+    wakeup_.notify();
+
+    for (auto &[id, r] : canceled) {
+        complete_(std::move(r), connection(), std::make_error_code(std::errc::operation_canceled));
+    }
+
+    // Note: The network thread cancels the requests that it has already taken.
+    thread_.join();
+}
+
+connect_request_id connector::async_connect(
+    const resolve_result &remote_endpoints, connect_handler handler) {
+    return async_connect(remote_endpoints, std::move(handler), config_.default_options);
+}
+
+connect_request_id connector::async_connect(
+    const resolve_result &remote_endpoints,
+    connect_handler handler,
+    const connect_options &options,
+    executor handler_executor) {
+    request r;
+    r.remote_endpoints = remote_endpoints;
+    r.options          = options;
+    r.handler          = std::move(handler);
+    r.handler_executor = std::move(handler_executor);
+
+    connect_request_id id;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        id = next_id_++;
+
+        size_t pending_count = submitted_.size() + in_progress_.size();
+        if (stopping_ || pending_count >= config_.max_pending_requests) {
+            lock.unlock();
+            complete_(
+                std::move(r),
+                connection(),
+                std::make_error_code(std::errc::resource_unavailable_try_again));
+            return id;
+        }
+
+        submitted_.emplace(id, std::move(r));
+    }
+    wakeup_.notify();
+
+    return id;
+}
+
+bool connector::cancel(connect_request_id id) {
+    request r;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // A request that the network thread has taken is finished by that thread
+        if (in_progress_.erase(id) != 0) {
+            canceled_.push_back(id);
+            wakeup_.notify();
+            return true;
+        }
+
+        auto it = submitted_.find(id);
+        if (it == submitted_.end()) return false;
+
+        r = std::move(it->second);
+        submitted_.erase(it);
+    }
+
+    complete_(std::move(r), connection(), std::make_error_code(std::errc::operation_canceled));
+    return true;
+}
+
+size_t connector::pending_requests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return submitted_.size() + in_progress_.size();
+}
+
+/// @brief Race the connection attempts of every request taken from other threads, until this
+/// connector stops.
+void connector::network_thread_function_() {
+    struct race_state {
+        request r;
+        std::unique_ptr<detail::connect_race> race;
+    };
+
+    std::map<connect_request_id, race_state> races;
+    std::map<socket_type, connect_request_id> race_ids_by_fd;
+
+    detail::poll_group poller(detail::socket_status::writable);
+    poller.add_socket(wakeup_.native_handle());
+    poller.modify_socket(wakeup_.native_handle(), detail::socket_status::readable);
+
+    // Stop waiting on the attempts of a race that is over (or canceled), and call its handler
+    auto finish_race = [&](connect_request_id id, bool is_canceled) {
+        auto it = races.find(id);
+        for (socket_type socket_fd : it->second.race->attempts()) {
+            poller.remove_socket(socket_fd);
+            race_ids_by_fd.erase(socket_fd);
+        }
+
+        socket_type socket_fd = it->second.race->release();
+        std::error_code ec;
+        // TODO(Caleb): Custom error categories?
+        if (socket_fd == 0) ec.assign(errno, std::system_category());
+
+        request r = std::move(it->second.r);
+        races.erase(it);
+
+        // Note: A request that was canceled while its race ended is reported as canceled.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (in_progress_.erase(id) == 0) is_canceled = true;
+        }
+
+        if (is_canceled) {
+            if (socket_fd != 0) detail::socket_ops::close_socket(socket_fd);
+            complete_(
+                std::move(r), connection(), std::make_error_code(std::errc::operation_canceled));
+            return;
+        }
+
+        connection conn;
+        if (socket_fd != 0) {
+            conn = connection::from_native_socket(
+                socket_fd, detail::socket_ops::get_remote_endpoint(socket_fd));
+        }
+        complete_(std::move(r), std::move(conn), ec);
+    };
+
+    while (true) {
+        // Take the requests made and canceled since the last iteration
+        std::map<connect_request_id, request> submitted;
+        std::vector<connect_request_id> canceled;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) break;
+
+            submitted.swap(submitted_);
+            canceled.swap(canceled_);
+            for (const auto &[id, r] : submitted) in_progress_.insert(id);
+        }
+
+        for (auto &[id, r] : submitted) {
+            auto race = std::make_unique<detail::connect_race>(r.remote_endpoints, r.options);
+            races.emplace(id, race_state{std::move(r), std::move(race)});
+        }
+
+        for (connect_request_id id : canceled) {
+            if (races.count(id) != 0) finish_race(id, true);
+        }
+
+        // Start the attempts that are due, finish the races that are over, and find the next time
+        // that an attempt is due or a race times out
+        int timeout_millis = -1;
+        for (auto it = races.begin(); it != races.end();) {
+            connect_request_id id      = it->first;
+            detail::connect_race &race = *it->second.race;
+            it++;
+
+            size_t attempt_count = race.attempts().size();
+            race.start_due_attempts();
+            for (size_t i = attempt_count; i < race.attempts().size(); i++) {
+                poller.add_socket(race.attempts()[i]);
+                race_ids_by_fd[race.attempts()[i]] = id;
+            }
+
+            if (race.is_finished()) {
+                finish_race(id, false);
+                continue;
+            }
+
+            int race_timeout_millis = race.timeout_millis();
+            if (race_timeout_millis >= 0 &&
+                (timeout_millis < 0 || race_timeout_millis < timeout_millis)) {
+                timeout_millis = race_timeout_millis;
+            }
+        }
+
+        // Wait for attempts to finish, or for the next attempt or timeout to be due
+        for (const auto &event : poller.poll(timeout_millis)) {
+            if (event.socket_fd == wakeup_.native_handle()) {
+                wakeup_.reset();
+                continue;
+            }
+
+            auto owner = race_ids_by_fd.find(event.socket_fd);
+            if (owner == race_ids_by_fd.end()) continue;
+
+            // Note: The socket must leave the poll group before the race closes it.
+            poller.remove_socket(event.socket_fd);
+            races.at(owner->second).race->finish_attempt(event.socket_fd);
+            race_ids_by_fd.erase(owner);
+        }
+    }
+
+    // Cancel the requests that are still in progress
+    while (!races.empty()) finish_race(races.begin()->first, true);
+
+    poller.remove_socket(wakeup_.native_handle());
+}
+
+/// @brief Call the handler of a finished request, through its executor if it has one.
+/// @param r The finished request.
+/// @param conn The connection, if the request succeeded.
+/// @param ec The error that the request finished with, if any.
+void connector::complete_(request &&r, connection conn, std::error_code ec) {
+    if (!r.handler) return;
+
+    if (r.handler_executor) {
+        // Note: Tasks must be copyable, so the connection is shared with the task.
+        auto shared_conn = std::make_shared<connection>(std::move(conn));
+        r.handler_executor([handler = std::move(r.handler), shared_conn, ec]() {
+            handler(std::move(*shared_conn), ec);
+        });
+    } else {
+        r.handler(std::move(conn), ec);
+    }
+}
+
+}  // namespace yonaa
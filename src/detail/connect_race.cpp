@@ -0,0 +1,177 @@
+#include "yonaa/detail/connect_race.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include "yonaa/detail/socket_ops.hpp"
+
+namespace yonaa::detail {
+
+namespace {
+
+/// @brief Return the endpoints provided, reordered so that their address families alternate,
+/// starting with the family of the first endpoint. Endpoints of the same family keep their order.
+resolve_result interleave_address_families(const resolve_result &endpoints) {
+    if (endpoints.empty()) return {};
+
+    int first_family = endpoints.front().family();
+
+    resolve_result preferred, others;
+    for (const endpoint &e : endpoints) {
+        (e.family() == first_family ? preferred : others).push_back(e);
+    }
+
+    resolve_result result;
+    result.reserve(endpoints.size());
+    for (size_t i = 0; i < preferred.size() || i < others.size(); i++) {
+        if (i < preferred.size()) result.push_back(preferred[i]);
+        if (i < others.size()) result.push_back(others[i]);
+    }
+
+    return result;
+}
+
+/// @brief Start a non-blocking connection attempt to the endpoint provided.
+/// @param is_connected Set to true if the attempt succeeded right away.
+/// @return The socket of the attempt, or 0 (with errno set) if it failed right away.
+socket_type start_connect(const endpoint &e, bool &is_connected) {
+    int socket_fd = ::socket(e.family(), SOCK_STREAM | SOCK_NONBLOCK, e.protocol());
+    if (socket_fd == -1) return 0;
+
+    int connect_result = ::connect(socket_fd, e.data(), e.size());
+    if (connect_result == -1 && errno != EINPROGRESS) {
+        socket_ops::close_preserving_errno(socket_fd);
+        return 0;
+    }
+
+    is_connected = (connect_result == 0);
+    return socket_fd;
+}
+
+}  // namespace
+
+connect_race::connect_race(const resolve_result &remote_endpoints, const connect_options &options)
+    : options_(options),
+      candidates_(interleave_address_families(remote_endpoints)),
+      next_candidate_(0),
+      next_attempt_time_(clock_type::now()),
+      deadline_(clock_type::now() + options.timeout),
+      connected_fd_(0),
+      last_error_(EINVAL) {}
+
+connect_race::~connect_race() {
+    close_attempts_();
+    if (connected_fd_ != 0) ::close(connected_fd_);
+}
+
+void connect_race::start_due_attempts() {
+    while (!is_finished() && next_candidate_ < candidates_.size()) {
+        auto now = clock_type::now();
+        if (!attempts_.empty() && now < next_attempt_time_) return;
+
+        bool is_connected     = false;
+        socket_type socket_fd = start_connect(candidates_[next_candidate_], is_connected);
+
+        next_attempt_time_ =
+            now + ((next_candidate_ == 0) ? options_.connect_delay : options_.stagger_interval);
+        next_candidate_++;
+
+        if (socket_fd == 0) {
+            // Note: As with RFC 8305, a failed attempt lets the next one start right away.
+            last_error_        = errno;
+            next_attempt_time_ = now;
+        } else if (is_connected) {
+            connected_fd_ = socket_fd;
+        } else {
+            attempts_.push_back(socket_fd);
+        }
+    }
+}
+
+void connect_race::finish_attempt(socket_type socket_fd) {
+    auto it = std::find(attempts_.begin(), attempts_.end(), socket_fd);
+    if (it == attempts_.end()) return;
+    attempts_.erase(it);
+
+    int error      = 0;
+    socklen_t size = sizeof(error);
+    if (getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &error, &size) == -1) error = errno;
+
+    if (error == 0 && connected_fd_ == 0) {
+        connected_fd_ = socket_fd;
+        return;
+    }
+
+    ::close(socket_fd);
+    if (error != 0) {
+        last_error_        = error;
+        next_attempt_time_ = clock_type::now();
+    }
+}
+
+bool connect_race::is_finished() const {
+    if (connected_fd_ != 0) return true;
+    if (attempts_.empty() && next_candidate_ >= candidates_.size()) return true;
+
+    return is_timed_out_(clock_type::now());
+}
+
+int connect_race::timeout_millis() const {
+    auto now = clock_type::now();
+
+    bool has_wakeup = false;
+    clock_type::time_point wakeup;
+
+    if (next_candidate_ < candidates_.size()) {
+        wakeup     = next_attempt_time_;
+        has_wakeup = true;
+    }
+
+    if (options_.timeout.count() > 0 && (!has_wakeup || deadline_ < wakeup)) {
+        wakeup     = deadline_;
+        has_wakeup = true;
+    }
+
+    if (!has_wakeup) return -1;
+
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wakeup - now);
+    return (int)std::max<int64_t>(remaining.count(), 0);
+}
+
+socket_type connect_race::release() {
+    // Note: A race that ends with attempts left over (or yet to be started) ran out of time.
+    bool is_exhausted = attempts_.empty() && next_candidate_ >= candidates_.size();
+    close_attempts_();
+
+    socket_type socket_fd = connected_fd_;
+    connected_fd_         = 0;
+
+    if (socket_fd == 0) {
+        errno = is_exhausted ? last_error_ : ETIMEDOUT;
+        return 0;
+    }
+
+    // Connections are blocking unless they are made otherwise
+    if (!socket_ops::set_non_blocking(socket_fd, false)) {
+        socket_ops::close_preserving_errno(socket_fd);
+        return 0;
+    }
+
+    return socket_fd;
+}
+
+/// @brief Return true if this race has a timeout, and it has passed.
+bool connect_race::is_timed_out_(clock_type::time_point now) const {
+    return options_.timeout.count() > 0 && now >= deadline_;
+}
+
+/// @brief Close the sockets of every attempt in progress.
+void connect_race::close_attempts_() {
+    for (socket_type socket_fd : attempts_) ::close(socket_fd);
+    attempts_.clear();
+}
+
+}  // namespace yonaa::detail
@@ -1,11 +1,34 @@
 #include "yonaa/detail/poll.hpp"
 
 #include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "yonaa/logging.hpp"
 
 namespace yonaa::detail {
 
+#if defined(YONAA_HAS_EPOLL)
+/// @brief The maximum number of events that a single call to epoll_wait() may return. Any sockets
+/// that are still ready after that will be reported by the next call.
+static const size_t max_epoll_events = 1024;
+#endif
+
 namespace detail {
 
+/// @brief Return the poll events that represent the statuses described by a socket_status_mask.
+/// @param config The statuses to convert.
+/// @return The poll events that represent the statuses described by a socket_status_mask.
+int events_from_ssm(socket_status_mask config) {
+    int events = 0;
+
+    events |= (config & socket_status::readable) ? POLLIN : 0;
+    events |= (config & socket_status::writable) ? POLLOUT : 0;
+
+    return events;
+}
+
 /// @brief Return a socket_status_mask that represents the status described by revents.
 /// @param revents The events to convert.
 /// @return A socket_status_mask that represents the status described by revents.
@@ -20,40 +43,151 @@ socket_status_mask ssm_from_revents(int revents) {
     return ssm;
 }
 
+#if defined(YONAA_HAS_EPOLL)
+/// @brief Return a socket_status_mask that represents the status described by epoll events.
+/// @param events The events to convert.
+/// @return A socket_status_mask that represents the status described by epoll events.
+socket_status_mask ssm_from_epoll_events(uint32_t events) {
+    socket_status_mask ssm;
+
+    ssm |= (events & EPOLLIN) ? socket_status::readable : socket_status::none;
+    ssm |= (events & EPOLLOUT) ? socket_status::writable : socket_status::none;
+    ssm |= (events & EPOLLERR) ? socket_status::error : socket_status::none;
+    ssm |= (events & EPOLLHUP) ? socket_status::hung_up : socket_status::none;
+
+    return ssm;
+}
+#endif
+
 }  // namespace detail
 
-socket_status_mask poll_socket(socket_type socket_fd, int timeout_millis) {
+socket_status_mask poll_socket(
+    socket_type socket_fd, int timeout_millis, socket_status_mask config) {
     pollfd pfd = {0, 0, 0};
     pfd.fd     = socket_fd;
-    pfd.events = POLLIN | POLLOUT;
+    pfd.events = (short)detail::events_from_ssm(config);
 
     int num_events = ::poll(&pfd, 1, timeout_millis);
 
     return (num_events > 0) ? detail::ssm_from_revents(pfd.revents) : socket_status::none;
 }
 
-poll_group::poll_group(socket_status_mask config) : pfd_config_(0) {
-    pfd_config_ |= (config & socket_status::readable) ? POLLIN : 0;
-    pfd_config_ |= (config & socket_status::writable) ? POLLOUT : 0;
+poll_group::poll_group(socket_status_mask config, poll_backend backend, bool edge_triggered)
+    : backend_(poll_backend::poll), size_(0), pfd_config_(detail::events_from_ssm(config)) {
+#if defined(YONAA_HAS_EPOLL)
+    epoll_fd_     = -1;
+    epoll_config_ = 0;
+    epoll_config_ |= (config & socket_status::readable) ? (uint32_t)EPOLLIN : 0;
+    epoll_config_ |= (config & socket_status::writable) ? (uint32_t)EPOLLOUT : 0;
+    epoll_config_ |= (edge_triggered) ? (uint32_t)EPOLLET : 0;
+
+    if (backend == poll_backend::epoll) {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+
+        if (epoll_fd_ != -1) {
+            backend_ = poll_backend::epoll;
+        } else {
+            YONAA_INTERNAL_WARN("Unable to create an epoll instance; falling back to poll()");
+        }
+    }
+#else
+    (void)backend;
+    (void)edge_triggered;
+#endif
+}
+
+poll_group::~poll_group() {
+#if defined(YONAA_HAS_EPOLL)
+    if (epoll_fd_ != -1) ::close(epoll_fd_);
+#endif
 }
 
 void poll_group::add_socket(socket_type socket_fd) {
+#if defined(YONAA_HAS_EPOLL)
+    if (backend_ == poll_backend::epoll) {
+        epoll_event event = {};
+        event.events      = epoll_config_;
+        event.data.fd     = socket_fd;
+
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_fd, &event) == -1) {
+            YONAA_INTERNAL_WARN("Unable to add fd={} to the poll group ({})", socket_fd, errno);
+            return;
+        }
+
+        size_++;
+        return;
+    }
+#endif
+
     pollfd pfd = {0, 0, 0};
     pfd.fd     = socket_fd;
     pfd.events = pfd_config_;
 
     pfds_.push_back(pfd);
+    size_++;
 }
 
 void poll_group::remove_socket(socket_type socket_fd) {
+#if defined(YONAA_HAS_EPOLL)
+    if (backend_ == poll_backend::epoll) {
+        // Note: Closing a socket removes it from the epoll set as well, so this only fails if the
+        // socket was never added or has already been closed.
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket_fd, nullptr) == 0 || errno == EBADF) {
+            if (size_ > 0) size_--;
+        }
+
+        return;
+    }
+#endif
+
     auto is_target_pfd = [&](pollfd pfd) { return pfd.fd == socket_fd; };
     pfds_.erase(std::remove_if(pfds_.begin(), pfds_.end(), is_target_pfd), pfds_.end());
+    size_ = pfds_.size();
+}
+
+void poll_group::modify_socket(socket_type socket_fd, socket_status_mask config) {
+    int events = detail::events_from_ssm(config);
+
+#if defined(YONAA_HAS_EPOLL)
+    if (backend_ == poll_backend::epoll) {
+        epoll_event event = {};
+        event.events      = (uint32_t)events | (epoll_config_ & (uint32_t)EPOLLET);
+        event.data.fd     = socket_fd;
+
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_fd, &event) == -1) {
+            YONAA_INTERNAL_WARN("Unable to modify fd={} in the poll group ({})", socket_fd, errno);
+        }
+
+        return;
+    }
+#endif
+
+    for (pollfd &pfd : pfds_) {
+        if (pfd.fd == socket_fd) pfd.events = (short)events;
+    }
 }
 
 poll_result poll_group::poll(int timeout_millis) {
+    poll_result result;
+
+#if defined(YONAA_HAS_EPOLL)
+    if (backend_ == poll_backend::epoll) {
+        epoll_events_.resize(std::clamp<size_t>(size_, 1, max_epoll_events));
+
+        int num_events =
+            ::epoll_wait(epoll_fd_, epoll_events_.data(), epoll_events_.size(), timeout_millis);
+
+        for (int i = 0; i < num_events; i++) {
+            const epoll_event &event = epoll_events_[i];
+            result.push_back({event.data.fd, detail::ssm_from_epoll_events(event.events)});
+        }
+
+        return result;
+    }
+#endif
+
     (void)::poll(pfds_.data(), pfds_.size(), timeout_millis);
 
-    poll_result result;
     for (const pollfd &pfd : pfds_) {
         if (!pfd.revents) continue;
 
@@ -64,7 +198,11 @@ poll_result poll_group::poll(int timeout_millis) {
 }
 
 size_t poll_group::size() const {
-    return pfds_.size();
+    return size_;
+}
+
+poll_backend poll_group::backend() const {
+    return backend_;
 }
 
 }  // namespace yonaa::detail::poll
@@ -1,7 +1,17 @@
 #include "yonaa/detail/socket_ops.hpp"
 
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include "yonaa/detail/connect_race.hpp"
+
 namespace yonaa::detail::socket_ops {
 
 namespace detail {
@@ -33,46 +43,162 @@ endpoint get_endpoint(socket_type socket_fd, bool local_socket) {
     return endpoint::from_native_address(protocol, (address_type *)&ss, ss_size);
 }
 
+/// @brief Set the options of a listening socket that must be in place before it is bound.
+/// @return True if every option was set, and false otherwise.
+bool configure_listening_socket(socket_type socket_fd, const acceptor_options &options) {
+    int on = 1;
+
+    // Enable SO_REUSEADDR if necessary
+    if (options.reuse_address) {
+        int sso_result = setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (sso_result == -1) return false;
+    }
+
+    // Enable SO_REUSEPORT if necessary
+    if (options.reuse_port) {
+        int sso_result = setsockopt(socket_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+        if (sso_result == -1) return false;
+    }
+
+    if (options.fast_open_queue_length > 0) {
+        int queue_length = options.fast_open_queue_length;
+        int sso_result   = setsockopt(
+            socket_fd, IPPROTO_TCP, TCP_FASTOPEN, &queue_length, sizeof(queue_length));
+        if (sso_result == -1) return false;
+    }
+
+    if (options.incoming_cpu >= 0) {
+#if defined(SO_INCOMING_CPU)
+        int cpu        = options.incoming_cpu;
+        int sso_result = setsockopt(socket_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+        if (sso_result == -1) return false;
+#else
+        errno = ENOPROTOOPT;
+        return false;
+#endif
+    }
+
+    return true;
+}
+
+/// @brief Return a socket that is bound to the endpoint provided and listening on it, or 0 (with
+/// errno set) if any step fails.
+socket_type open_listening_socket(
+    const endpoint &e, const acceptor_options &options, bool v6_only) {
+    // Attempt to get a socket handle
+    int socket_fd = ::socket(e.family(), SOCK_STREAM, e.protocol());
+    if (socket_fd == -1) return 0;
+
+    if (!configure_listening_socket(socket_fd, options)) {
+        close_preserving_errno(socket_fd);
+        return 0;
+    }
+
+    if (v6_only && e.family() == AF_INET6) {
+        int on         = 1;
+        int sso_result = setsockopt(socket_fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+        if (sso_result == -1) {
+            close_preserving_errno(socket_fd);
+            return 0;
+        }
+    }
+
+    int bind_result = ::bind(socket_fd, e.data(), e.size());
+    if (bind_result == -1) {
+        close_preserving_errno(socket_fd);
+        return 0;
+    }
+
+    int listen_result = ::listen(socket_fd, options.backlog);
+    if (listen_result == -1) {
+        close_preserving_errno(socket_fd);
+        return 0;
+    }
+
+    // Note: TCP_DEFER_ACCEPT only applies to a listening socket.
+    if (options.defer_accept.count() > 0) {
+        int seconds    = (int)options.defer_accept.count();
+        int sso_result = setsockopt(
+            socket_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds));
+        if (sso_result == -1) {
+            close_preserving_errno(socket_fd);
+            return 0;
+        }
+    }
+
+    return socket_fd;
+}
+
 }  // namespace detail
 
-socket_type create_connected_socket(const resolve_result &remote_endpoints) {
-    for (const endpoint &e : remote_endpoints) {
-        int socket_fd = ::socket(e.family(), SOCK_STREAM, e.protocol());
-        if (socket_fd == -1) continue;
+socket_type create_connected_socket(
+    const resolve_result &remote_endpoints, const connect_options &options) {
+    connect_race race(remote_endpoints, options);
+
+    std::vector<pollfd> pfds;
+    while (true) {
+        race.start_due_attempts();
+        if (race.is_finished()) break;
 
-        int connect_result = ::connect(socket_fd, e.data(), e.size());
-        if (connect_result == -1) continue;
+        // Wait for an attempt to finish, or for the next one (or the timeout) to be due
+        pfds.clear();
+        for (socket_type socket_fd : race.attempts()) pfds.push_back({socket_fd, POLLOUT, 0});
 
-        return socket_fd;
+        int poll_result = ::poll(pfds.data(), pfds.size(), race.timeout_millis());
+        if (poll_result == -1) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+
+        for (const pollfd &pfd : pfds) {
+            if (pfd.revents != 0) race.finish_attempt(pfd.fd);
+        }
     }
 
-    return 0;
+    return race.release();
+}
+
+socket_type create_listening_socket(
+    const resolve_result &local_endpoints,
+    uint64_t backlog_size,
+    bool reuse_addr,
+    bool reuse_port) {
+    acceptor_options options;
+    options.backlog       = (int)backlog_size;
+    options.reuse_address = reuse_addr;
+    options.reuse_port    = reuse_port;
+
+    return create_listening_socket(local_endpoints, options);
 }
 
 socket_type create_listening_socket(
-    const resolve_result &local_endpoints, uint64_t backlog_size, bool reuse_addr) {
+    const resolve_result &local_endpoints, const acceptor_options &options) {
     for (const endpoint &e : local_endpoints) {
-        // Attempt to get a socket handle
-        int socket_fd = ::socket(e.family(), SOCK_STREAM, e.protocol());
-        if (socket_fd == -1) continue;
-
-        // Enable SO_REUSEADDR if necessary
-        if (reuse_addr) {
-            int on         = 1;
-            int sso_result = setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
-            if (sso_result == -1) continue;
-        }
+        socket_type socket_fd = detail::open_listening_socket(e, options, false);
+        if (socket_fd != 0) return socket_fd;
+    }
+
+    return 0;
+}
 
-        int bind_result = ::bind(socket_fd, e.data(), e.size());
-        if (bind_result == -1) continue;
+std::vector<socket_type> create_listening_sockets(
+    const resolve_result &local_endpoints, const acceptor_options &options) {
+    // Note: An IPv6 socket bound to an unspecified address also accepts IPv4 connections by
+    // default, which would collide with an IPv4 socket bound to the same port.
+    bool v6_only = std::any_of(local_endpoints.begin(), local_endpoints.end(), [](const auto &e) {
+        return e.family() == AF_INET;
+    });
 
-        int listen_result = ::listen(socket_fd, backlog_size);
-        if (listen_result == -1) continue;
+    std::vector<socket_type> socket_fds;
+    for (auto it = local_endpoints.begin(); it != local_endpoints.end(); it++) {
+        // Skip endpoints that appear more than once
+        if (std::find(local_endpoints.begin(), it, *it) != it) continue;
 
-        return socket_fd;
+        socket_type socket_fd = detail::open_listening_socket(*it, options, v6_only);
+        if (socket_fd != 0) socket_fds.push_back(socket_fd);
     }
 
-    return 0;
+    return socket_fds;
 }
 
 endpoint get_local_endpoint(socket_type socket_fd) {
@@ -83,6 +209,114 @@ endpoint get_remote_endpoint(socket_type socket_fd) {
     return detail::get_endpoint(socket_fd, false);
 }
 
+bool set_non_blocking(socket_type socket_fd, bool non_blocking) {
+    int flags = ::fcntl(socket_fd, F_GETFL, 0);
+    if (flags == -1) return false;
+
+    flags = (non_blocking) ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return ::fcntl(socket_fd, F_SETFL, flags) != -1;
+}
+
+bool set_connection_options(socket_type socket_fd, const connection_options &options) {
+    auto set_int = [socket_fd](int level, int name, int value) {
+        return setsockopt(socket_fd, level, name, &value, sizeof(value)) != -1;
+    };
+
+    if (options.no_delay && !set_int(IPPROTO_TCP, TCP_NODELAY, *options.no_delay)) return false;
+
+    if (options.send_buffer_size && !set_int(SOL_SOCKET, SO_SNDBUF, *options.send_buffer_size)) {
+        return false;
+    }
+
+    if (options.receive_buffer_size &&
+        !set_int(SOL_SOCKET, SO_RCVBUF, *options.receive_buffer_size)) {
+        return false;
+    }
+
+    if (options.quick_ack && !set_int(IPPROTO_TCP, TCP_QUICKACK, *options.quick_ack)) return false;
+
+    if (options.busy_poll && !set_int(SOL_SOCKET, SO_BUSY_POLL, (int)options.busy_poll->count())) {
+        return false;
+    }
+
+    if (options.not_sent_low_watermark &&
+        !set_int(IPPROTO_TCP, TCP_NOTSENT_LOWAT, *options.not_sent_low_watermark)) {
+        return false;
+    }
+
+    if (options.keep_alive && !set_int(SOL_SOCKET, SO_KEEPALIVE, *options.keep_alive)) return false;
+
+    if (options.keep_alive_idle &&
+        !set_int(IPPROTO_TCP, TCP_KEEPIDLE, (int)options.keep_alive_idle->count())) {
+        return false;
+    }
+
+    if (options.keep_alive_interval &&
+        !set_int(IPPROTO_TCP, TCP_KEEPINTVL, (int)options.keep_alive_interval->count())) {
+        return false;
+    }
+
+    if (options.keep_alive_count && !set_int(IPPROTO_TCP, TCP_KEEPCNT, *options.keep_alive_count)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool get_connection_options(socket_type socket_fd, connection_options &options) {
+    bool is_ok   = true;
+    auto get_int = [socket_fd, &is_ok](int level, int name) {
+        int value      = 0;
+        socklen_t size = sizeof(value);
+        if (getsockopt(socket_fd, level, name, &value, &size) == -1) is_ok = false;
+        return value;
+    };
+
+    // Note: The kernel reports the buffer sizes that it doubled, so they are halved to match the
+    // values that were set.
+    options.no_delay               = get_int(IPPROTO_TCP, TCP_NODELAY) != 0;
+    options.send_buffer_size       = get_int(SOL_SOCKET, SO_SNDBUF) / 2;
+    options.receive_buffer_size    = get_int(SOL_SOCKET, SO_RCVBUF) / 2;
+    options.quick_ack              = get_int(IPPROTO_TCP, TCP_QUICKACK) != 0;
+    options.busy_poll              = std::chrono::microseconds(get_int(SOL_SOCKET, SO_BUSY_POLL));
+    options.not_sent_low_watermark = get_int(IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+    options.keep_alive             = get_int(SOL_SOCKET, SO_KEEPALIVE) != 0;
+    options.keep_alive_idle        = std::chrono::seconds(get_int(IPPROTO_TCP, TCP_KEEPIDLE));
+    options.keep_alive_interval    = std::chrono::seconds(get_int(IPPROTO_TCP, TCP_KEEPINTVL));
+    options.keep_alive_count       = get_int(IPPROTO_TCP, TCP_KEEPCNT);
+
+    return is_ok;
+}
+
+ssize_t send_iovecs(socket_type socket_fd, const iovec *iovecs, size_t iovec_count, int flags) {
+    msghdr message     = {};
+    message.msg_iov    = const_cast<iovec *>(iovecs);
+    message.msg_iovlen = std::min<size_t>(iovec_count, IOV_MAX);
+
+    return ::sendmsg(socket_fd, &message, flags);
+}
+
+ssize_t receive_iovecs(socket_type socket_fd, const iovec *iovecs, size_t iovec_count, int flags) {
+    msghdr message     = {};
+    message.msg_iov    = const_cast<iovec *>(iovecs);
+    message.msg_iovlen = std::min<size_t>(iovec_count, IOV_MAX);
+
+    return ::recvmsg(socket_fd, &message, flags);
+}
+
+void advance_iovecs(iovec *&iovecs, size_t &iovec_count, size_t bytes) {
+    while (iovec_count > 0 && bytes >= iovecs->iov_len) {
+        bytes -= iovecs->iov_len;
+        iovecs++;
+        iovec_count--;
+    }
+
+    if (iovec_count == 0) return;
+
+    iovecs->iov_base = (char *)iovecs->iov_base + bytes;
+    iovecs->iov_len -= bytes;
+}
+
 void close_socket(socket_type socket_fd) {
     // Note(Caleb): shutdown() does not fail meaningfully for our use cases, so we don't do any
     // error checking here.
@@ -92,4 +326,10 @@ void close_socket(socket_type socket_fd) {
     ::close(socket_fd);
 }
 
+void close_preserving_errno(socket_type socket_fd) {
+    int saved_errno = errno;
+    ::close(socket_fd);
+    errno = saved_errno;
+}
+
 }  // namespace yonaa::detail::socket_ops
@@ -0,0 +1,223 @@
+#include "yonaa/detail/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace yonaa::detail {
+
+namespace {
+
+// The number of tasks a strand runs before yielding its worker to other queued work
+constexpr size_t max_strand_batch = 16;
+
+// The pool and queue that the calling thread works for, if any
+thread_local const void *current_pool  = nullptr;
+thread_local size_t current_queue_index = 0;
+
+}  // namespace
+
+thread_pool::thread_pool(size_t thread_count, size_t max_queued_tasks)
+    : max_queued_tasks_(std::max<size_t>(max_queued_tasks, 1)),
+      next_queue_(0),
+      queued_tasks_(0),
+      runnables_(0),
+      unfinished_(0),
+      stopping_(false),
+      sleeping_workers_(0),
+      blocked_submitters_(0) {
+    thread_count = std::max<size_t>(thread_count, 1);
+
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) queues_.push_back(std::make_unique<worker_queue>());
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+        threads_.emplace_back([this, i]() { worker_function_(i); });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for (auto &thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void thread_pool::submit(std::function<void()> task) {
+    wait_for_space_();
+    push_([this, task = std::move(task)]() {
+        task_started_();
+        task();
+    });
+}
+
+void thread_pool::submit(const std::shared_ptr<strand> &s, std::function<void()> task) {
+    wait_for_space_();
+
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        s->tasks.push_back(std::move(task));
+
+        // The strand is already queued or running, and will pick this task up in order
+        if (s->is_scheduled) return;
+        s->is_scheduled = true;
+    }
+
+    push_([this, s]() { run_strand_(s); });
+}
+
+bool thread_pool::is_worker_thread() const {
+    return current_pool == this;
+}
+
+size_t thread_pool::size() const {
+    return threads_.size();
+}
+
+void thread_pool::worker_function_(size_t index) {
+    current_pool        = this;
+    current_queue_index = index;
+
+    std::function<void()> runnable;
+    while (true) {
+        if (try_pop_(index, runnable)) {
+            runnable();
+            runnable = nullptr;
+
+            // Note: Workers that are still running may queue more work (a busy strand re-queues
+            // itself), so the pool is only finished once nothing is queued and nothing is running.
+            if (unfinished_.fetch_sub(1) == 1 && stopping_) {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                work_available_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        sleeping_workers_++;
+        work_available_.wait(lock, [this]() {
+            return runnables_ > 0 || (stopping_ && unfinished_ == 0);
+        });
+        sleeping_workers_--;
+
+        if (stopping_ && unfinished_ == 0) return;
+    }
+}
+
+void thread_pool::wait_for_space_() {
+    // Note: Workers never wait here. A worker waiting on the pool to drain could be the only one
+    // left to drain it.
+    if (current_pool == this) {
+        queued_tasks_++;
+        return;
+    }
+
+    if (try_reserve_space_()) return;
+
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    blocked_submitters_++;
+    space_available_.wait(lock, [this]() { return try_reserve_space_(); });
+    blocked_submitters_--;
+}
+
+/// @brief Count one more queued task if the pool has space for it.
+/// @return True if the task was counted, and false if the pool is full.
+bool thread_pool::try_reserve_space_() {
+    size_t count = queued_tasks_;
+    while (count < max_queued_tasks_) {
+        if (queued_tasks_.compare_exchange_weak(count, count + 1)) return true;
+    }
+
+    return false;
+}
+
+void thread_pool::push_(std::function<void()> runnable) {
+    // Workers keep their own work local, and everyone else spreads it across the queues
+    size_t index = current_pool == this ? current_queue_index
+                                        : next_queue_.fetch_add(1, std::memory_order_relaxed);
+    worker_queue &queue = *queues_[index % queues_.size()];
+
+    unfinished_++;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(runnable));
+        runnables_++;
+    }
+
+    // Note: A worker counts itself as sleeping before it checks for work, so either it sees this
+    // entry or this sees it.
+    if (sleeping_workers_ > 0) {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        work_available_.notify_one();
+    }
+}
+
+bool thread_pool::try_pop_(size_t index, std::function<void()> &runnable) {
+    // Take the oldest entry from our own queue first...
+    for (size_t i = 0; i < queues_.size(); i++) {
+        worker_queue &queue = *queues_[(index + i) % queues_.size()];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+
+        // ...and otherwise steal the newest entry from someone else's
+        if (i == 0) {
+            runnable = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            runnable = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+
+        runnables_--;
+        return true;
+    }
+
+    return false;
+}
+
+void thread_pool::run_strand_(const std::shared_ptr<strand> &s) {
+    for (size_t i = 0; i < max_strand_batch; i++) {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (s->tasks.empty()) {
+                s->is_scheduled = false;
+                return;
+            }
+
+            task = std::move(s->tasks.front());
+            s->tasks.pop_front();
+        }
+
+        task_started_();
+        task();
+    }
+
+    // The strand still has work; queue it behind everything else so that one busy strand cannot
+    // starve the others
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        if (s->tasks.empty()) {
+            s->is_scheduled = false;
+            return;
+        }
+    }
+
+    push_([this, s]() { run_strand_(s); });
+}
+
+void thread_pool::task_started_() {
+    queued_tasks_--;
+
+    if (blocked_submitters_ > 0) {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        space_available_.notify_one();
+    }
+}
+
+}  // namespace yonaa::detail
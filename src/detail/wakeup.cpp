@@ -0,0 +1,52 @@
+#include "yonaa/detail/wakeup.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include <cstdint>
+
+namespace yonaa::detail {
+
+wakeup_event::wakeup_event() : read_fd_(-1), write_fd_(-1) {
+#if defined(__linux__)
+    read_fd_  = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    write_fd_ = read_fd_;
+#else
+    int fds[2];
+    if (::pipe(fds) == 0) {
+        for (int fd : fds) {
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+
+        read_fd_  = fds[0];
+        write_fd_ = fds[1];
+    }
+#endif
+}
+
+wakeup_event::~wakeup_event() {
+    if (write_fd_ != read_fd_) ::close(write_fd_);
+    if (read_fd_ != -1) ::close(read_fd_);
+}
+
+void wakeup_event::notify() {
+    // Note: A full counter (or pipe) is already readable, so a failed write can be ignored.
+    uint64_t one = 1;
+    (void)!::write(write_fd_, &one, sizeof(one));
+}
+
+void wakeup_event::reset() {
+    uint64_t scratch[16];
+    while (::read(read_fd_, scratch, sizeof(scratch)) > 0) {}
+}
+
+socket_type wakeup_event::native_handle() const {
+    return read_fd_;
+}
+
+}  // namespace yonaa::detail
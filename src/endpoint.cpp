@@ -2,21 +2,23 @@
 
 #include <arpa/inet.h>
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "yonaa/detail/sockaddr_ops.hpp"
 
 namespace yonaa {
 
-endpoint::endpoint() : protocol_(0), storage_(sizeof(sockaddr_storage)) {}
+endpoint::endpoint() : protocol_(0), size_(sizeof(address_storage_type)), storage_() {}
 
 endpoint endpoint::from_native_address(
     protocol_type protocol, address_type *addr, address_size_type addr_size) {
     endpoint e;
     e.protocol_ = protocol;
-    e.storage_  = buffer(addr_size);
+    e.size_     = std::min<address_size_type>(addr_size, sizeof(address_storage_type));
 
-    std::memcpy(e.data(), addr, addr_size);
+    std::memcpy(&e.storage_, addr, e.size_);
 
     return e;
 }
@@ -30,26 +32,25 @@ protocol_type endpoint::protocol() const {
 }
 
 address_type *endpoint::data() {
-    return storage_.as<address_type>();
+    return (address_type *)&storage_;
 }
 
 const address_type *endpoint::data() const {
-    return storage_.as<address_type>();
+    return (const address_type *)&storage_;
 }
 
 address_size_type endpoint::size() const {
-    return storage_.size();
+    return size_;
 }
 
 std::string endpoint::addr() const {
-    buffer buffer(INET6_ADDRSTRLEN);
-    inet_ntop(AF_INET, detail::sockaddr_ops::get_in_addr(data()), buffer.data(), buffer.size());
+    char text[INET6_ADDRSTRLEN] = {};
+    inet_ntop(data()->sa_family, detail::sockaddr_ops::get_in_addr(data()), text, sizeof(text));
 
     switch (data()->sa_family) {
         case AF_INET:
-            return std::string(buffer.data(), INET_ADDRSTRLEN);
         case AF_INET6:
-            return std::string(buffer.data(), INET6_ADDRSTRLEN);
+            return std::string(text);
         default:
             return "INVALID";
     }
@@ -1,8 +1,112 @@
 #include "yonaa/resolve.hpp"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+
+#include "yonaa/addresses.hpp"
 #include "yonaa/detail/getaddrinfo.hpp"
 
 namespace yonaa {
+
+/// @brief Parse a service given as a decimal port number.
+/// @param service The service to be parsed.
+/// @param port The port number, in network byte order, if the service is one.
+/// @return True if the service is a port number, and false otherwise.
+static bool parse_numeric_port(const std::string &service, in_port_t &port) {
+    if (service.empty() || service.size() > 5) return false;
+
+    unsigned long value = 0;
+    for (char c : service) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (unsigned long)(c - '0');
+    }
+    if (value > 65535) return false;
+
+    port = htons((uint16_t)value);
+    return true;
+}
+
+/// @brief Return the address families that getaddrinfo() yields for any_address on this host,
+/// looked up once and then reused. These are the families that AI_ADDRCONFIG lets through.
+/// @return The address families that getaddrinfo() yields for any_address on this host.
+static const std::vector<int> &any_address_families() {
+    // Note: The families are cached for the life of the process, so an address family that is
+    // configured (or removed) on this host after the first lookup is not noticed.
+    static const std::vector<int> families = [] {
+        std::vector<int> result;
+
+        gai_result_type *target_info = detail::gai::getaddrinfo(any_address, "0");
+        for (gai_result_type *ai = target_info; ai != nullptr; ai = ai->ai_next) {
+            result.push_back(ai->ai_family);
+        }
+        if (target_info) freeaddrinfo(target_info);
+
+        return result;
+    }();
+
+    return families;
+}
+
+/// @brief Return true if getaddrinfo() yields addresses of a family on this host, and false
+/// otherwise.
+/// @param family The address family.
+/// @return True if getaddrinfo() yields addresses of the family on this host, and false otherwise.
+static bool is_configured_family(int family) {
+    const std::vector<int> &families = any_address_families();
+    return std::find(families.begin(), families.end(), family) != families.end();
+}
+
+/// @brief Build the endpoints for a numeric address and port directly, as getaddrinfo() would.
+/// @param hostname The hostname, which is only used if it is any_address or a numeric IPv4 or IPv6
+/// address.
+/// @param port The port number, in network byte order.
+/// @param result The endpoints, if the hostname is numeric.
+/// @return True if the hostname is numeric, and false otherwise. Numeric addresses of a family
+/// that this host has no address for are left to getaddrinfo(), which treats them the same way.
+static bool resolve_numeric(const std::string &hostname, in_port_t port, resolve_result &result) {
+    sockaddr_in addr4 = {};
+    addr4.sin_family  = AF_INET;
+    addr4.sin_port    = port;
+
+    sockaddr_in6 addr6 = {};
+    addr6.sin6_family  = AF_INET6;
+    addr6.sin6_port    = port;
+
+    if (hostname == any_address) {
+        // Note: The unspecified addresses are all zeroes, like the structures above.
+        result.reserve(any_address_families().size());
+        for (int family : any_address_families()) {
+            if (family == AF_INET) {
+                result.push_back(endpoint::from_native_address(
+                    IPPROTO_TCP, (address_type *)&addr4, sizeof(addr4)));
+            } else if (family == AF_INET6) {
+                result.push_back(endpoint::from_native_address(
+                    IPPROTO_TCP, (address_type *)&addr6, sizeof(addr6)));
+            }
+        }
+        return !result.empty();
+    }
+
+    if (is_configured_family(AF_INET) &&
+        inet_pton(AF_INET, hostname.c_str(), &addr4.sin_addr) == 1) {
+        result.push_back(
+            endpoint::from_native_address(IPPROTO_TCP, (address_type *)&addr4, sizeof(addr4)));
+        return true;
+    }
+
+    // Note: Addresses with a scope ("fe80::1%eth0") are left to getaddrinfo().
+    if (is_configured_family(AF_INET6) &&
+        inet_pton(AF_INET6, hostname.c_str(), &addr6.sin6_addr) == 1) {
+        result.push_back(
+            endpoint::from_native_address(IPPROTO_TCP, (address_type *)&addr6, sizeof(addr6)));
+        return true;
+    }
+
+    return false;
+}
+
 resolve_result resolve(const std::string &hostname, const std::string &service) {
     // Delegate function call and throw if necessary
     std::error_code ec;
@@ -15,6 +119,13 @@ resolve_result resolve(const std::string &hostname, const std::string &service)
 
 resolve_result resolve(
     const std::string &hostname, const std::string &service, std::error_code &ec) {
+    // Numeric addresses and ports are built directly, without the cost of getaddrinfo()
+    in_port_t port;
+    if (parse_numeric_port(service, port)) {
+        resolve_result result;
+        if (resolve_numeric(hostname, port, result)) return result;
+    }
+
     gai_result_type *target_info = detail::gai::getaddrinfo(hostname, service);
     if (!target_info) {
         // TODO(Caleb): Error handling here
@@ -0,0 +1,109 @@
+#include "yonaa/resolver_cache.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace yonaa {
+
+resolver_cache::resolver_cache(const resolver_cache_config &config) : config_(config) {}
+
+resolve_result resolver_cache::resolve(const std::string &hostname, const std::string &service) {
+    // Delegate function call and throw if necessary
+    std::error_code ec;
+    auto result = resolve(hostname, service, ec);
+
+    if (ec) throw ec;
+
+    return result;
+}
+
+resolve_result resolver_cache::resolve(
+    const std::string &hostname, const std::string &service, std::error_code &ec) {
+    key_type key(hostname, service);
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+
+        auto it = entries_.find(key);
+        if (it != entries_.end() && clock_type::now() < it->second.expiry) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+
+            if (it->second.ec) ec = it->second.ec;
+            return it->second.endpoints;
+        }
+    }
+
+    // Note: The name is resolved without holding the lock, so that a slow lookup does not hold up
+    // lookups of other names. Threads that miss on the same name at once each resolve it.
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    std::error_code resolve_ec;
+    resolve_result result = yonaa::resolve(hostname, service, resolve_ec);
+
+    bool is_failure               = resolve_ec || result.empty();
+    std::chrono::milliseconds ttl = is_failure ? config_.negative_ttl : config_.ttl;
+    if (ttl.count() > 0 && config_.max_entries > 0) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        auto now = clock_type::now();
+        if (entries_.find(key) == entries_.end()) make_room_(now);
+        entries_[key] = {result, resolve_ec, now + ttl};
+    }
+
+    if (resolve_ec) ec = resolve_ec;
+    return result;
+}
+
+void resolver_cache::invalidate(const std::string &hostname, const std::string &service) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    entries_.erase(key_type(hostname, service));
+}
+
+void resolver_cache::invalidate(const std::string &hostname) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // Keys are ordered by hostname first, so every service of a hostname is stored together
+    auto first = entries_.lower_bound(key_type(hostname, std::string()));
+    auto last  = first;
+    while (last != entries_.end() && last->first.first == hostname) last++;
+
+    entries_.erase(first, last);
+}
+
+void resolver_cache::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t resolver_cache::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
+
+uint64_t resolver_cache::hits() const {
+    return hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t resolver_cache::misses() const {
+    return misses_.load(std::memory_order_relaxed);
+}
+
+/// @brief Make room for one more result, if the cache is full. Expired results are dropped first,
+/// and then the result closest to expiring. Must be called with the lock held exclusively.
+/// @param now The current time.
+void resolver_cache::make_room_(clock_type::time_point now) {
+    if (entries_.size() < config_.max_entries) return;
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = (it->second.expiry <= now) ? entries_.erase(it) : std::next(it);
+    }
+
+    if (entries_.size() < config_.max_entries) return;
+
+    auto soonest = std::min_element(entries_.begin(), entries_.end(), [](auto &a, auto &b) {
+        return a.second.expiry < b.second.expiry;
+    });
+    entries_.erase(soonest);
+}
+
+}  // namespace yonaa
@@ -1,36 +1,146 @@
 #include "yonaa/server.hpp"
 
+#include <algorithm>
+#include <cerrno>
+
 #include "yonaa/addresses.hpp"
+#include "yonaa/detail/socket_ops.hpp"
 #include "yonaa/logging.hpp"
 #include "yonaa/resolve.hpp"
 
 namespace yonaa {
 
-static client_id next_available_id = 1;
+/// @brief The number of low bits of a client_id that hold the index of the reactor serving the
+/// client, so that calls for a client can be routed to its reactor without a lookup.
+static const size_t reactor_index_bits = 8;
+
+/// @brief The maximum number of reactors that a server may run.
+static const size_t max_reactor_count = (size_t)1 << reactor_index_bits;
+
+/// @brief The server whose network thread is the calling thread, if any.
+static thread_local const server *current_network_server = nullptr;
+
+/// @brief The most bytes that are received from a client at once.
+static const size_t max_receive_size = 8192;
+
+/// @brief The most queued buffers that are gathered into a single write to a client's socket.
+static const size_t max_gathered_buffers = 64;
+
+/// @brief The most connections that are accepted each time a reactor's listening socket is
+/// readable. Any more are accepted on the next wakeup, once the reactor's clients have been served.
+static const size_t max_accepts_per_wakeup = 256;
+
+/// @brief Return the number of bytes in a message held in several buffers.
+/// @param msg The buffers that hold the message.
+/// @return The number of bytes in the message.
+static size_t message_size(const std::vector<shared_buffer> &msg) {
+    size_t size = 0;
+    for (const auto &part : msg) size += (part) ? part->size() : 0;
+
+    return size;
+}
+
+/// @brief Return a copy of a message that can be queued for any number of clients.
+/// @param msg The message to be copied.
+/// @return A copy of the message, without any empty parts.
+static std::vector<shared_buffer> copy_message(buffer_sequence msg) {
+    std::vector<shared_buffer> parts;
+    parts.reserve(msg.size());
+    for (size_t i = 0; i < msg.size(); i++) {
+        if (!msg[i].empty()) parts.push_back(make_shared_buffer(buffer(msg[i])));
+    }
+
+    return parts;
+}
+
+/// @brief Return the poll group backend that implements a particular poll mechanism.
+/// @param mechanism The mechanism to convert.
+/// @return The poll group backend that implements a particular poll mechanism.
+static detail::poll_backend backend_from_mechanism(poll_mechanism mechanism) {
+    switch (mechanism) {
+        case poll_mechanism::poll:
+            return detail::poll_backend::poll;
+        case poll_mechanism::epoll:
+            return detail::poll_backend::epoll;
+        case poll_mechanism::automatic:
+            break;
+    }
+
+    return detail::default_poll_backend;
+}
+
+server::reactor::reactor(size_t index, const server_config &config)
+    : index(index),
+      poller(detail::socket_status::readable, backend_from_mechanism(config.mechanism)) {}
 
-server::server(uint16_t port)
-    : port_(port),
-      running_(false),
-      has_disconnected_clients_(false),
-      poll_group_(detail::socket_status::readable) {}
+server::server(uint16_t port, const server_config &config)
+    : port_(port), config_(config), running_(false) {
+    size_t reactor_count = config_.reactor_count;
+    if (reactor_count == 0) reactor_count = std::max(1u, std::thread::hardware_concurrency());
+    reactor_count = std::min(reactor_count, max_reactor_count);
+
+    for (size_t i = 0; i < reactor_count; i++) {
+        reactors_.push_back(std::make_unique<reactor>(i, config_));
+    }
+
+    if (config_.handler_thread_count > 0) {
+        handler_pool_ = std::make_unique<detail::thread_pool>(
+            config_.handler_thread_count, config_.handler_queue_depth);
+    }
+}
 
 server::~server() {
-    if (network_thread_.joinable()) {
-        YONAA_INTERNAL_TRACE("Joining the network thread");
-        network_thread_.join();
+    for (auto &r : reactors_) {
+        if (r->thread.joinable()) {
+            YONAA_INTERNAL_TRACE("Joining network thread {}", r->index);
+            r->thread.join();
+        }
     }
+
+    // Finish the queued handler calls while the reactors that they may message still exist
+    handler_pool_.reset();
 }
 
 void server::run() {
     if (running_) return;
+    running_ = true;
+
+    // Open every reactor's acceptor before any network thread starts, so that connections are
+    // spread across all of them from the start
+    resolve_result endpoints;
+    for (const std::string &address : config_.listen_addresses) {
+        resolve_result address_endpoints = resolve(address, std::to_string(port_), ec_);
+        if (ec_) {
+            YONAA_INTERNAL_ERROR(
+                "Unable to resolve the local address: {}:{}", address, std::to_string(port_));
+            std::exit(EXIT_FAILURE);
+        }
+
+        endpoints.insert(endpoints.end(), address_endpoints.begin(), address_endpoints.end());
+    }
+
+    for (auto &r : reactors_) {
+        acceptor_options options = config_.listener_options;
+        if (reactors_.size() > 1) options.reuse_port = true;
+        if (options.incoming_cpu >= 0) options.incoming_cpu += (int)r->index;
+
+        r->listener.open(endpoints, ec_, options);
+        if (ec_) {
+            YONAA_INTERNAL_ERROR("Unable to open an acceptor for network thread {}", r->index);
+            std::exit(EXIT_FAILURE);
+        }
+    }
 
-    // Start network thread
-    YONAA_INTERNAL_TRACE("Spawning network thread");
-    network_thread_ = std::thread(&server::network_thread_function_, this);
+    // Start network threads
+    for (auto &r : reactors_) {
+        YONAA_INTERNAL_TRACE("Spawning network thread {}", r->index);
+        r->thread = std::thread(&server::network_thread_function_, this, std::ref(*r));
+    }
 }
 
 void server::stop() {
     running_ = false;
+    for (auto &r : reactors_) { r->wakeup.notify(); }
     YONAA_INTERNAL_TRACE("Stop signal received");
 }
 
@@ -46,201 +156,681 @@ void server::set_client_disconnect_handler(const client_disconnect_handler &hand
     on_client_disconnect_ = handler;
 }
 
-void server::message_client(const buffer &msg, client_id client_id) {
-    // Find the client being specified
-    client_info *client = client_info_from_id(client_id);
-    if (!client || !client->is_connected) return;
+void server::set_send_queue_high_watermark_handler(const send_queue_watermark_handler &handler) {
+    on_send_queue_high_ = handler;
+}
+
+void server::set_send_queue_low_watermark_handler(const send_queue_watermark_handler &handler) {
+    on_send_queue_low_ = handler;
+}
 
-    client->conn.send(msg, ec_);
+void server::message_client(buffer_view msg, client_id client_id) {
+    message_client(buffer_sequence{msg}, client_id);
+}
 
-    // If the send fails, assume the client is disconnected
-    if (ec_) remove_client(client_id);
+void server::message_client(const shared_buffer &msg, client_id client_id) {
+    message_client(std::vector<shared_buffer>{msg}, client_id);
 }
 
-void server::message_all_clients(const buffer &msg, client_id exclude_client_id) {
-    for (const auto &client : clients_) {
-        if (client->id == exclude_client_id) continue;
+void server::message_client(buffer_sequence msg, client_id client_id) {
+    reactor *r = reactor_from_id_(client_id);
+    if (!r) return;
 
-        message_client(msg, client->id);
+    if (is_reactor_thread_(*r)) {
+        std::vector<shared_buffer> copy;
+        send_views_to_client_(*r, msg, client_id, copy);
+        return;
+    }
+
+    message_client(copy_message(msg), client_id);
+}
+
+void server::message_client(const std::vector<shared_buffer> &msg, client_id client_id) {
+    reactor *r = reactor_from_id_(client_id);
+    if (!r) return;
+
+    if (is_reactor_thread_(*r)) {
+        send_to_client_(*r, msg, client_id, nullptr);
+        return;
+    }
+
+    // Note: Network and handler threads never wait for room in a send queue, since the network
+    // thread that would make room may itself be waiting on them.
+    bool should_wait = config_.overflow_policy == send_queue_overflow_policy::block &&
+                       current_network_server != this &&
+                       !(handler_pool_ && handler_pool_->is_worker_thread()) && running_;
+
+    if (!should_wait) {
+        post_(*r, [this, r, msg, client_id]() { send_to_client_(*r, msg, client_id, nullptr); });
+        return;
+    }
+
+    auto on_queued = std::make_shared<std::promise<void>>();
+    auto is_queued = on_queued->get_future();
+    post_(*r, [this, r, msg, client_id, on_queued]() {
+        send_to_client_(*r, msg, client_id, on_queued);
+    });
+
+    // Note: If the reactor stops first, the promise is destroyed unfulfilled, which ends the wait
+    // as well.
+    is_queued.wait();
+}
+
+void server::message_all_clients(buffer_view msg, client_id exclude_client_id) {
+    // Note: Every client that needs the whole message, including those of the other reactors,
+    // shares a single copy of it.
+    std::vector<shared_buffer> copy;
+
+    for (auto &r : reactors_) {
+        if (is_reactor_thread_(*r)) {
+            for (const auto &client : r->clients) {
+                if (client.id == exclude_client_id) continue;
+
+                send_views_to_client_(*r, buffer_sequence{msg}, client.id, copy);
+            }
+
+            continue;
+        }
+
+        if (copy.empty()) copy = copy_message(buffer_sequence{msg});
+
+        reactor *target = r.get();
+        post_(*target, [this, target, copy, exclude_client_id]() {
+            message_reactor_clients_(*target, copy, exclude_client_id);
+        });
+    }
+}
+
+void server::message_all_clients(const shared_buffer &msg, client_id exclude_client_id) {
+    std::vector<shared_buffer> parts{msg};
+
+    for (auto &r : reactors_) {
+        if (is_reactor_thread_(*r)) {
+            message_reactor_clients_(*r, parts, exclude_client_id);
+            continue;
+        }
+
+        reactor *target = r.get();
+        post_(*target, [this, target, parts, exclude_client_id]() {
+            message_reactor_clients_(*target, parts, exclude_client_id);
+        });
     }
 }
 
 void server::remove_client(client_id client_id) {
+    reactor *r = reactor_from_id_(client_id);
+    if (!r) {
+        YONAA_INTERNAL_WARN("Removal failed: client {} does not belong to this server", client_id);
+        return;
+    }
+
+    if (!is_reactor_thread_(*r)) {
+        post_(*r, [this, client_id]() { remove_client(client_id); });
+        return;
+    }
+
     YONAA_INTERNAL_TRACE("Attempting to mark client {} for removal", client_id);
 
-    client_info *client = client_info_from_id(client_id);
+    client_info *client = client_info_from_id(*r, client_id);
     if (!client) {
         YONAA_INTERNAL_WARN("Removal failed: could not find information for client {}", client_id);
         return;
     }
 
-    client->is_connected      = false;
-    has_disconnected_clients_ = true;
+    if (client->is_connected) {
+        client->is_connected = false;
+        r->disconnected_clients.push_back(client_id);
+    }
     YONAA_INTERNAL_DEBUG("Successfully marked client {} for removal", client_id);
 }
 
-/// @brief Run the network operations associated with this server.
-void server::network_thread_function_() {
-    running_ = true;
-
-    // Open the acceptor on the user's port
-    resolve_result endpoints = resolve(any_address, std::to_string(port_), ec_);
-    if (ec_) {
-        YONAA_INTERNAL_ERROR(
-            "Unable to resolve the local address: {}:{}", any_address, std::to_string(port_));
-        std::exit(EXIT_FAILURE);
-    }
+/// @brief Run the network operations associated with a single reactor of this server.
+/// @param r The reactor to run.
+void server::network_thread_function_(reactor &r) {
+    r.thread_id            = std::this_thread::get_id();
+    current_network_server = this;
 
-    // TODO(Caleb): Make reuse_address an option in the API
-    acceptor_.open(endpoints, ec_, acceptor_config::reuse_address);
-    if (ec_) {
-        YONAA_INTERNAL_ERROR("Unable to open an acceptor");
-        std::exit(EXIT_FAILURE);
-    }
+    // Wait on the acceptor and the wakeup event along with the clients
+    const std::vector<socket_type> &listener_fds = r.listener.native_sockets();
+    for (socket_type listener_fd : listener_fds) r.poller.add_socket(listener_fd);
+    r.poller.add_socket(r.wakeup.native_handle());
 
     while (running_) {
-        handle_incoming_connections_();
-        handle_incoming_messages_();
-        handle_disconnected_clients_();
+        detail::poll_result events = r.poller.poll((int)config_.max_wait.count());
+
+        for (const auto &event : events) {
+            if (!running_) break;
+
+            if (event.socket_fd == r.wakeup.native_handle()) {
+                handle_pending_tasks_(r);
+            } else if (std::find(listener_fds.begin(), listener_fds.end(), event.socket_fd) !=
+                       listener_fds.end()) {
+                handle_incoming_connections_(r);
+            } else {
+                handle_incoming_messages_(r, event);
+            }
+        }
+
+        handle_disconnected_clients_(r);
+    }
 
-        // TODO(Caleb): Make this sleep configurable
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // Release any threads waiting on this reactor, since it will not run their tasks
+    {
+        std::lock_guard<std::mutex> lock(r.pending_tasks_mutex);
+        r.is_stopped = true;
+        r.pending_tasks.clear();
     }
+    for (auto &client : r.clients) { client.blocked_sends.clear(); }
 
-    acceptor_.close();
-    YONAA_INTERNAL_TRACE("Network thread ended");
+    r.poller.remove_socket(r.wakeup.native_handle());
+    for (socket_type listener_fd : listener_fds) r.poller.remove_socket(listener_fd);
+    r.listener.close();
+    YONAA_INTERNAL_TRACE("Network thread {} ended", r.index);
 }
 
-/// @brief Accept all currently pending connections and, add them as clients to the server.
-void server::handle_incoming_connections_() {
-    while (running_) {
-        if (!acceptor_.has_pending_connection()) break;
+/// @brief Run the tasks handed to a reactor by other threads.
+/// @param r The reactor whose tasks should be run.
+void server::handle_pending_tasks_(reactor &r) {
+    // Note: Reset before taking the tasks, so that a task posted after the swap leaves the wakeup
+    // event readable for the next iteration.
+    r.wakeup.reset();
+
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(r.pending_tasks_mutex);
+        tasks.swap(r.pending_tasks);
+    }
 
-        client_id new_client_id = next_available_id++;
-        YONAA_INTERNAL_DEBUG(
-            "Connection request received. Attempting to create client {}", new_client_id);
+    for (auto &task : tasks) { task(); }
+}
 
-        // Create the new client
-        auto new_client  = std::make_unique<client_info>();
-        new_client->id   = new_client_id;
-        new_client->conn = acceptor_.accept(ec_);
-        new_client->fd   = new_client->conn.native_socket();
+/// @brief Accept the currently pending connections (up to max_accepts_per_wakeup of them) without
+/// blocking, and add them as clients to the server.
+/// @param r The reactor whose acceptor has pending connections.
+void server::handle_incoming_connections_(reactor &r) {
+    if (!running_) return;
 
-        if (ec_) {
-            YONAA_INTERNAL_WARN(
-                "Error accepting a connection; unable to create client {}", new_client_id);
-            next_available_id--;
+    std::error_code ec;
+    std::vector<connection> connections = r.listener.accept_batch(max_accepts_per_wakeup, ec);
+    if (ec) { YONAA_INTERNAL_WARN("Error accepting a connection; unable to create a client"); }
 
-            continue;
+    for (connection &conn : connections) {
+        // Add the new client to the server
+        detail::slot_map<client_info>::key_type key = r.clients.emplace();
+        client_info *new_client                     = r.clients.find(key);
+
+        client_id new_client_id  = (key << reactor_index_bits) | (client_id)r.index;
+        new_client->id           = new_client_id;
+        new_client->conn         = std::move(conn);
+        new_client->fd           = new_client->conn.native_socket();
+        new_client->is_connected = true;
+        if (handler_pool_) new_client->strand = std::make_shared<detail::strand>();
+
+        std::error_code options_ec;
+        new_client->conn.set_options(config_.client_options, options_ec);
+        if (options_ec) {
+            YONAA_INTERNAL_WARN("Unable to set the socket options of client {}", new_client_id);
         }
 
-        // Add the new client to the server
-        clients_.push_back(std::move(new_client));
-        clients_.back()->is_connected = true;
-        poll_group_.add_socket(clients_.back()->fd);
+        if ((size_t)new_client->fd >= r.client_ids_by_fd.size()) {
+            r.client_ids_by_fd.resize(new_client->fd + 1, 0);
+        }
+        r.client_ids_by_fd[new_client->fd] = new_client_id;
+        r.poller.add_socket(new_client->fd);
 
         // Notify the user that a new client has connected
         YONAA_INTERNAL_DEBUG("Client {} created", new_client_id);
-        on_client_connect_(new_client_id);
+        if (handler_pool_) {
+            handler_pool_->submit(new_client->strand, [this, new_client_id]() {
+                on_client_connect_(new_client_id);
+            });
+        } else {
+            on_client_connect_(new_client_id);
+        }
     }
 
 #if YONAA_INTERNAL_CURRENT_LOG_LEVEL < YONAA_INTERNAL_LOG_LEVEL_INFO
-    YONAA_INTERNAL_TRACE("{} active clients", clients_.size());
-    if (clients_.size() > 0) {
-        for (const auto &client : clients_) { YONAA_INTERNAL_TRACE("\t{}", *client); }
+    YONAA_INTERNAL_TRACE("{} active clients", r.clients.size());
+    if (r.clients.size() > 0) {
+        for (const auto &client : r.clients) { YONAA_INTERNAL_TRACE("\t{}", client.id); }
     }
 #endif
 }
 
-/// @brief Poll the connections being managed by the server and handle any incoming data.
-void server::handle_incoming_messages_() {
-    detail::poll_result events = poll_group_.poll();
+/// @brief Handle a status change on one of the connections being managed by the server.
+/// @param r The reactor that serves the connection.
+/// @param event The socket that changed and its new status.
+void server::handle_incoming_messages_(reactor &r, const detail::socket_status_info &event) {
+    const auto &[socket_fd, status] = event;
+    YONAA_INTERNAL_TRACE("Handling events for fd={}, (status = {})", socket_fd, status.bits());
+
+    // Figure out which client we're processing
+    client_info *client = client_info_from_native_socket(r, socket_fd);
+    if (!client) {
+        YONAA_INTERNAL_ERROR("Unable to find client with fd={}", socket_fd);
+        return;
+    }
 
-    for (const auto &[socket_fd, status] : events) {
-        if (!running_) return;
+    if (status & (detail::socket_status::error | detail::socket_status::hung_up)) {
+        // Assume that the client has disconnected
+        YONAA_INTERNAL_DEBUG(
+            "Handling socket error for client {}. Marking for removal", client->id);
+        remove_client(client->id);
+        return;
+    }
 
-        YONAA_INTERNAL_TRACE("Handling events for fd={}, (status = {})", socket_fd, status.bits());
+    if (status & detail::socket_status::writable) {
+        flush_send_queue_(r, *client);
+        if (!client->is_connected) return;
+    }
 
-        // Figure out which client we're processing
-        client_info *client = client_info_from_native_socket(socket_fd);
-        if (!client) {
-            YONAA_INTERNAL_ERROR("Unable to find client with fd={}", socket_fd);
-            continue;
+    if (status & detail::socket_status::readable) {
+        YONAA_INTERNAL_DEBUG(
+            "Handling readable event for fd={} for client {}", socket_fd, client->id);
+        buffer &data = r.receive_buffer;
+        data.resize_uninitialized(max_receive_size);
+
+        // Note: The socket is read directly rather than through the connection, which would close
+        // it on EOF. It stays open (and in the poll group) until the client is removed, so that
+        // its descriptor cannot be handed to a new client while the poll group still watches it.
+        iovec data_iovec      = {data.data(), data.size()};
+        ssize_t recv_result   = detail::socket_ops::receive_iovecs(client->fd, &data_iovec, 1, 0);
+        size_t bytes_received = (recv_result > 0) ? (size_t)recv_result : 0;
+
+        // The socket is non-blocking, so a readable report that turns out to be stale is harmless
+        if (recv_result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
         }
 
-        if (status & (detail::socket_status::error | detail::socket_status::hung_up)) {
-            // Assume that the client has disconnected
+        // If the receive failed or no data was received, assume that the client disconnected
+        if (bytes_received == 0) {
+            if (recv_result == -1) r.ec.assign(errno, std::system_category());
+
             YONAA_INTERNAL_DEBUG(
-                "Handling socket error for client {}. Marking for removal", client->id);
+                "Disconnect message received from client {}. Marking for removal", client->id);
             remove_client(client->id);
-            continue;
+            return;
         }
+        data.resize_uninitialized(bytes_received);
 
-        if (status & detail::socket_status::readable) {
-            YONAA_INTERNAL_DEBUG(
-                "Handling readable event for fd={} for client {}", socket_fd, client->id);
-            buffer data = client->conn.receive(ec_);
-
-            // If the receive failed or no data was received, assume that the client disconnected
-            if (ec_ || (data.size() == 0)) {
-                YONAA_INTERNAL_DEBUG(
-                    "Disconnect message received from client {}. Marking for removal", client->id);
-                remove_client(client->id);
-                continue;
+        // The kernel turns quick acks back off on its own, so they are re-enabled after each read
+        if (config_.client_options.quick_ack.value_or(false)) {
+            connection_options quick_ack_options;
+            quick_ack_options.quick_ack = true;
+
+            std::error_code quick_ack_ec;
+            client->conn.set_options(quick_ack_options, quick_ack_ec);
+            if (quick_ack_ec) {
+                YONAA_INTERNAL_WARN("Unable to re-enable quick acks for client {}", client->id);
             }
+        }
 
-            // Notify the user that the client sent some data
+        // Notify the user that the client sent some data. (Handlers that run on the pool outlive
+        // the receive buffer, so they get a copy of just the bytes received.)
+        if (handler_pool_) {
+            handler_pool_->submit(
+                client->strand,
+                [this, id = client->id, data = buffer(data.data(), bytes_received)]() {
+                    on_data_receive_(id, data);
+                });
+        } else {
             on_data_receive_(client->id, data);
         }
     }
 }
 
 /// @brief If present, physically and logically disconnect clients from the server and remove them.
-void server::handle_disconnected_clients_() {
-    if (!has_disconnected_clients_) return;
+/// @param r The reactor whose clients should be checked.
+void server::handle_disconnected_clients_(reactor &r) {
+    if (r.disconnected_clients.empty()) return;
+
+    // Note: Take the list first, since the disconnect handler may mark more clients for removal.
+    std::vector<client_id> disconnected_clients;
+    disconnected_clients.swap(r.disconnected_clients);
 
-    // Gather the "disconnected" clients
-    auto first_disconnected_client = std::remove_if(
-        clients_.begin(), clients_.end(), [](const auto &client) { return !client->is_connected; });
+    for (client_id id : disconnected_clients) {
+        client_info *client = client_info_from_id(r, id);
+        if (!client) continue;
 
-    // Physically and logically disconnect the clients
-    for (auto it = first_disconnected_client; it != clients_.end(); it++) {
-        client_info *client = it->get();
+        YONAA_INTERNAL_TRACE("Disconnecting client {}", id);
 
-        YONAA_INTERNAL_TRACE("Disconnecting client {}", client->id);
-        poll_group_.remove_socket(client->fd);
+        // Physically and logically disconnect the client
+        r.poller.remove_socket(client->fd);
+        r.client_ids_by_fd[client->fd] = 0;
         client->conn.disconnect();
-        on_client_disconnect_(client->id);
+
+        // Release any threads waiting for room in the client's send queue
+        for (auto &blocked_send : client->blocked_sends) {
+            if (blocked_send.second) blocked_send.second->set_value();
+        }
+        client->blocked_sends.clear();
+
+        if (handler_pool_) {
+            handler_pool_->submit(client->strand, [this, id]() { on_client_disconnect_(id); });
+        } else {
+            on_client_disconnect_(id);
+        }
+
+        // Remove the client from the server
+        r.clients.erase(id >> reactor_index_bits);
+    }
+}
+
+/// @brief Send data to a client, queueing whatever its socket cannot accept right away. Must be
+/// called on the network thread of the reactor that serves the client.
+/// @param r The reactor that serves the client.
+/// @param msg The data to be sent, in order.
+/// @param client_id The id of the client to receive the message.
+/// @param on_queued If not null, a promise that is fulfilled once the data has been sent, queued or
+/// discarded.
+void server::send_to_client_(
+    reactor &r,
+    const std::vector<shared_buffer> &msg,
+    client_id client_id,
+    const std::shared_ptr<std::promise<void>> &on_queued) {
+    client_info *client = client_info_from_id(r, client_id);
+    size_t size         = message_size(msg);
+    if (!client || !client->is_connected || size == 0) {
+        if (on_queued) on_queued->set_value();
+        return;
+    }
+
+    // Note: A message larger than the limit is still let into an empty queue, since it would never
+    // fit otherwise. Messages that are already being held back keep their place in line.
+    bool is_full = client->send_queue_size > 0 &&
+                   client->send_queue_size + size > config_.send_queue_limit;
+
+    if (is_full || !client->blocked_sends.empty()) {
+        switch (config_.overflow_policy) {
+            case send_queue_overflow_policy::drop:
+                YONAA_INTERNAL_WARN(
+                    "Send queue for client {} is full; dropping a message", client_id);
+                if (on_queued) on_queued->set_value();
+                return;
+
+            case send_queue_overflow_policy::disconnect:
+                YONAA_INTERNAL_WARN("Send queue for client {} is full; disconnecting", client_id);
+                remove_client(client_id);
+                if (on_queued) on_queued->set_value();
+                return;
+
+            case send_queue_overflow_policy::block:
+                client->blocked_sends.emplace_back(msg, on_queued);
+                return;
+        }
+    }
+
+    queue_message_(r, *client, msg);
+    update_send_queue_state_(r, *client);
+    if (on_queued) on_queued->set_value();
+}
+
+/// @brief Send data that the caller still owns to a client. Whatever the client's socket accepts
+/// right away is sent straight from the caller's storage, and only the rest is copied into the
+/// client's send queue. Must be called on the network thread of the reactor that serves the client.
+/// @param r The reactor that serves the client.
+/// @param msg The data to be sent, in order.
+/// @param client_id The id of the client to receive the message.
+/// @param copy A copy of the whole message, shared by every client that it is queued for in full.
+/// It is made here the first time that it is needed.
+void server::send_views_to_client_(
+    reactor &r, buffer_sequence msg, client_id client_id, std::vector<shared_buffer> &copy) {
+    client_info *client = client_info_from_id(r, client_id);
+    if (!client || !client->is_connected || msg.total_size() == 0) return;
+
+    // Note: The data may only skip the queue if nothing is queued or held back ahead of it.
+    size_t bytes_sent = 0;
+    if (client->send_queue.empty() && client->blocked_sends.empty()) {
+        bytes_sent = write_views_(r, *client, msg);
+        if (!client->is_connected) return;
+    }
+
+    if (bytes_sent == 0) {
+        if (copy.empty()) copy = copy_message(msg);
+        send_to_client_(r, copy, client_id, nullptr);
+        return;
+    }
+
+    std::vector<shared_buffer> remainder;
+    for (size_t i = 0; i < msg.size(); i++) {
+        buffer_view part = msg[i];
+        size_t skipped   = std::min(bytes_sent, part.size());
+        bytes_sent -= skipped;
+
+        if (skipped < part.size()) {
+            remainder.push_back(
+                make_shared_buffer(buffer(part.data() + skipped, part.size() - skipped)));
+        }
+    }
+
+    if (!remainder.empty()) send_to_client_(r, remainder, client_id, nullptr);
+}
+
+/// @brief Write as much of a message as a client's socket accepts right away, gathering its parts
+/// into a single write. The client's send queue must be empty.
+/// @param r The reactor that serves the client.
+/// @param client The client to receive the message.
+/// @param msg The data to be sent, in order.
+/// @return The number of bytes written, which is zero if the socket is full or the write fails.
+size_t server::write_views_(reactor &r, client_info &client, buffer_sequence msg) {
+    iovec iovecs[max_gathered_buffers];
+    size_t iovec_count = 0;
+    for (size_t i = 0; i < msg.size() && iovec_count < max_gathered_buffers; i++) {
+        buffer_view part = msg[i];
+        if (!part.empty()) iovecs[iovec_count++] = {(void *)part.data(), part.size()};
+    }
+
+    while (true) {
+        ssize_t send_result = detail::socket_ops::send_iovecs(
+            client.conn.native_socket(), iovecs, iovec_count, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (send_result >= 0) return (size_t)send_result;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+
+        // If the send fails, assume the client is disconnected
+        r.ec.assign(errno, std::system_category());
+        remove_client(client.id);
+        return 0;
+    }
+}
+
+/// @brief Queue a message behind any data that is already queued for a client, and send as much
+/// of it as the client's socket accepts right away.
+/// @param r The reactor that serves the client.
+/// @param client The client to receive the message.
+/// @param msg The data to be sent, in order.
+void server::queue_message_(
+    reactor &r, client_info &client, const std::vector<shared_buffer> &msg) {
+    bool was_empty = client.send_queue.empty();
+
+    for (const auto &part : msg) {
+        if (!part || part->size() == 0) continue;
+
+        client.send_queue.push_back(part);
+        client.send_queue_size += part->size();
     }
 
-    // Remove the disconnected clients from the server
-    clients_.erase(first_disconnected_client, clients_.end());
+    // Otherwise the socket is already known to be full, and the queue is written once it is not
+    if (was_empty) write_send_queue_(r, client);
+}
+
+/// @brief Write as much of a client's send queue as its socket accepts, gathering several queued
+/// buffers into each write.
+/// @param r The reactor that serves the client.
+/// @param client The client whose queue should be written.
+void server::write_send_queue_(reactor &r, client_info &client) {
+    iovec iovecs[max_gathered_buffers];
+    while (!client.send_queue.empty()) {
+        size_t iovec_count   = 0;
+        size_t bytes_to_send = 0;
+        size_t offset        = client.send_queue_offset;
+        for (const auto &part : client.send_queue) {
+            if (iovec_count == max_gathered_buffers) break;
+
+            iovecs[iovec_count++] = {(void *)(part->data() + offset), part->size() - offset};
+            bytes_to_send += part->size() - offset;
+            offset = 0;
+        }
+
+        ssize_t send_result = detail::socket_ops::send_iovecs(
+            client.conn.native_socket(), iovecs, iovec_count, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (send_result == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+
+            // If the send fails, assume the client is disconnected
+            r.ec.assign(errno, std::system_category());
+            remove_client(client.id);
+            return;
+        }
+
+        // Retire every buffer that was sent in full, and remember how much of the next was sent
+        size_t bytes_sent = (size_t)send_result;
+        client.send_queue_size -= bytes_sent;
+
+        bytes_sent += client.send_queue_offset;
+        while (!client.send_queue.empty() && bytes_sent >= client.send_queue.front()->size()) {
+            bytes_sent -= client.send_queue.front()->size();
+            client.send_queue.pop_front();
+        }
+        client.send_queue_offset = bytes_sent;
+
+        // Stop once the socket is full again
+        if ((size_t)send_result < bytes_to_send) return;
+    }
+}
+
+/// @brief Send as much queued data as a client's socket accepts, and then let held back messages
+/// into the room that frees up.
+/// @param r The reactor that serves the client.
+/// @param client The client whose queue should be flushed.
+void server::flush_send_queue_(reactor &r, client_info &client) {
+    write_send_queue_(r, client);
+
+    while (!client.blocked_sends.empty() && client.is_connected) {
+        auto &[msg, on_queued] = client.blocked_sends.front();
+
+        bool is_full = client.send_queue_size > 0 &&
+                       client.send_queue_size + message_size(msg) > config_.send_queue_limit;
+        if (is_full) break;
+
+        queue_message_(r, client, msg);
+        if (on_queued) on_queued->set_value();
+        client.blocked_sends.pop_front();
+    }
+
+    update_send_queue_state_(r, client);
+}
+
+/// @brief Watch a client's socket for writability for as long as it has queued data, and report
+/// any send queue watermarks that have been crossed.
+/// @param r The reactor that serves the client.
+/// @param client The client whose send queue has changed.
+void server::update_send_queue_state_(reactor &r, client_info &client) {
+    if (!client.is_connected) return;
+
+    bool should_watch_writable = !client.send_queue.empty();
+    if (should_watch_writable != client.is_watching_writable) {
+        client.is_watching_writable = should_watch_writable;
+        r.poller.modify_socket(
+            client.fd,
+            (should_watch_writable)
+                ? detail::socket_status::readable | detail::socket_status::writable
+                : detail::socket_status::readable);
+    }
+
+    const send_queue_watermark_handler *handler = nullptr;
+    if (!client.is_send_queue_high && client.send_queue_size >= config_.send_queue_high_watermark) {
+        client.is_send_queue_high = true;
+        handler                   = &on_send_queue_high_;
+    } else if (
+        client.is_send_queue_high && client.send_queue_size <= config_.send_queue_low_watermark) {
+        client.is_send_queue_high = false;
+        handler                   = &on_send_queue_low_;
+    }
+
+    if (!handler || !*handler) return;
+
+    client_id id        = client.id;
+    size_t queued_bytes = client.send_queue_size;
+    if (handler_pool_) {
+        handler_pool_->submit(client.strand, [handler, id, queued_bytes]() {
+            (*handler)(id, queued_bytes);
+        });
+    } else {
+        (*handler)(id, queued_bytes);
+    }
+}
+
+/// @brief Send data to every client served by a reactor, except (optionally) a single client.
+/// Must be called on the reactor's network thread.
+/// @param r The reactor whose clients should receive the data.
+/// @param msg The data to be sent.
+/// @param exclude_client_id If nonzero, the id of the client that this data should not be sent to.
+void server::message_reactor_clients_(
+    reactor &r, const std::vector<shared_buffer> &msg, client_id exclude_client_id) {
+    for (const auto &client : r.clients) {
+        if (client.id == exclude_client_id) continue;
+
+        send_to_client_(r, msg, client.id, nullptr);
+    }
+}
+
+/// @brief Return a non-owning pointer to the reactor that serves the client with the specified
+/// id, or nullptr if the id could not have been issued by this server.
+/// @param client_id The id of the client.
+/// @return A non-owning pointer to the reactor that serves the client with the specified id, or
+/// nullptr if the id could not have been issued by this server.
+server::reactor *server::reactor_from_id_(client_id client_id) {
+    size_t index = client_id & (max_reactor_count - 1);
+    return (index < reactors_.size()) ? reactors_[index].get() : nullptr;
+}
+
+/// @brief Return true if the calling thread is the network thread of the specified reactor.
+/// @param r The reactor to check.
+/// @return True if the calling thread is the network thread of the specified reactor.
+bool server::is_reactor_thread_(const reactor &r) const {
+    return std::this_thread::get_id() == r.thread_id.load();
+}
+
+/// @brief Hand a task to a reactor, waking its network thread up if it is waiting for network
+/// activity.
+/// @param r The reactor that should run the task.
+/// @param task The task to be run on the reactor's network thread.
+void server::post_(reactor &r, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(r.pending_tasks_mutex);
+        if (r.is_stopped) return;
+
+        r.pending_tasks.push_back(std::move(task));
+    }
+
+    r.wakeup.notify();
 }
 
 /// @brief Return a non-owning pointer to the client_info of the client with the specified id, or
 /// nullptr if no such client exists.
+/// @param r The reactor that serves the client.
 /// @param client_id The id of the client to search for.
 /// @return A non-owning pointer to the client_info of the client with the specified id, or nullptr
 /// if no such client exists.
-client_info *server::client_info_from_id(client_id client_id) {
-    auto it = std::find_if(
-        clients_.begin(), clients_.end(), [&](const auto &it) { return it->id == client_id; });
-
-    // Return the client's info if we could find it, and false otherwise
-    return (it != clients_.end()) ? it->get() : nullptr;
+client_info *server::client_info_from_id(reactor &r, client_id client_id) {
+    return r.clients.find(client_id >> reactor_index_bits);
 }
 
 /// @brief Return a non-owning pointer to the client_info of the client with the specified socket
 /// descriptor, or nullptr if no such client exists.
+/// @param r The reactor that serves the client.
 /// @param client_id The id of the client to search for.
 /// @return A non-owning pointer to the client_info of the client with the specified socket
 /// descriptor, or nullptr if no such client exists.
-client_info *server::client_info_from_native_socket(socket_type socket_fd) {
-    auto it = std::find_if(
-        clients_.begin(), clients_.end(), [&](const auto &it) { return it->fd == socket_fd; });
+client_info *server::client_info_from_native_socket(reactor &r, socket_type socket_fd) {
+    if (socket_fd < 0 || (size_t)socket_fd >= r.client_ids_by_fd.size()) return nullptr;
 
-    // Return the client's info if we could find it, and false otherwise
-    return (it != clients_.end()) ? it->get() : nullptr;
+    client_id id = r.client_ids_by_fd[socket_fd];
+    return (id != 0) ? client_info_from_id(r, id) : nullptr;
 }
 
 }  // namespace yonaa
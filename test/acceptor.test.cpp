@@ -1,6 +1,12 @@
 #include "yonaa/acceptor.hpp"
 
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <thread>
+#include <vector>
 
 #define CATCH_CONFIG_PREFIX_ALL
 #include <catch2/catch_test_macros.hpp>
@@ -88,10 +94,150 @@ CATCH_TEST_CASE("[yonaa::acceptor] Acceptor can be opened with valid endpoints",
         // An error should not have been reported...
         CATCH_REQUIRE_FALSE(ec);
 
-        // ... and the returned connection should be valid.
+        // ... and the returned connection should be valid...
         CATCH_REQUIRE(conn.is_connected());
 
+        // ... with the endpoints of both ends of the connection.
+        CATCH_REQUIRE(conn.local_endpoint().addr() == yonaa::loopback_address);
+        CATCH_REQUIRE(conn.local_endpoint().port() == service);
+        CATCH_REQUIRE(conn.remote_endpoint().addr() == yonaa::loopback_address);
+
         scs.server_done = true;
         if (client_thread.joinable()) client_thread.join();
     }
 }
+
+CATCH_TEST_CASE("[yonaa::acceptor] Pending connections can be accepted in batches", "[net]") {
+    yonaa::acceptor acceptor;
+    std::error_code ec;
+
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, service);
+    acceptor.open(endpoints, ec, yonaa::acceptor_config::reuse_address);
+    CATCH_REQUIRE_FALSE(ec);
+
+    // With no connections pending, a batch should be empty rather than blocking...
+    CATCH_REQUIRE(acceptor.accept_batch(16, ec).empty());
+    CATCH_REQUIRE_FALSE(ec);
+
+    // ... and with several pending, no more than the limit should be accepted at once...
+    yonaa::endpoint local_endpoint = acceptor.local_endpoint();
+    std::vector<int> client_fds;
+    for (int i = 0; i < 3; i++) {
+        int client_fd = ::socket(local_endpoint.family(), SOCK_STREAM, 0);
+        CATCH_REQUIRE(::connect(client_fd, local_endpoint.data(), local_endpoint.size()) == 0);
+        client_fds.push_back(client_fd);
+    }
+
+    auto first_batch = acceptor.accept_batch(2, ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(first_batch.size() == 2);
+
+    auto second_batch = acceptor.accept_batch(16, ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(second_batch.size() == 1);
+
+    // ... and the accepted sockets should be non-blocking and close-on-exec.
+    for (const auto &conn : first_batch) {
+        CATCH_REQUIRE(conn.is_connected());
+        CATCH_REQUIRE(::fcntl(conn.native_socket(), F_GETFL) & O_NONBLOCK);
+        CATCH_REQUIRE(::fcntl(conn.native_socket(), F_GETFD) & FD_CLOEXEC);
+        CATCH_REQUIRE(conn.remote_endpoint().addr() == yonaa::loopback_address);
+    }
+
+    for (int fd : client_fds) ::close(fd);
+}
+
+CATCH_TEST_CASE("[yonaa::acceptor] A failing batch keeps the connections it accepted", "[net]") {
+    yonaa::acceptor acceptor;
+    std::error_code ec;
+
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, service);
+    acceptor.open(endpoints, ec, yonaa::acceptor_config::reuse_address);
+    CATCH_REQUIRE_FALSE(ec);
+
+    yonaa::endpoint local_endpoint = acceptor.local_endpoint();
+    std::vector<int> client_fds;
+    for (int i = 0; i < 3; i++) {
+        int client_fd = ::socket(local_endpoint.family(), SOCK_STREAM, 0);
+        CATCH_REQUIRE(::connect(client_fd, local_endpoint.data(), local_endpoint.size()) == 0);
+        client_fds.push_back(client_fd);
+    }
+
+    // Leave room for exactly one more descriptor, so that the second accept fails with EMFILE
+    int lowest_free_fd = ::dup(0);
+    ::close(lowest_free_fd);
+
+    rlimit original_limit;
+    CATCH_REQUIRE(::getrlimit(RLIMIT_NOFILE, &original_limit) == 0);
+
+    rlimit tight_limit = original_limit;
+    tight_limit.rlim_cur = (rlim_t)lowest_free_fd + 1;
+    CATCH_REQUIRE(::setrlimit(RLIMIT_NOFILE, &tight_limit) == 0);
+
+    // The connection accepted before the error should be returned rather than thrown away...
+    std::vector<yonaa::connection> batch;
+    bool was_thrown = false;
+    try {
+        batch = acceptor.accept_batch(16);
+    } catch (const std::error_code &) {
+        was_thrown = true;
+    }
+
+    // ... and the error should be thrown by the next call, which accepts nothing.
+    std::error_code next_ec;
+    try {
+        (void)acceptor.accept_batch(16);
+    } catch (const std::error_code &e) {
+        next_ec = e;
+    }
+
+    ::setrlimit(RLIMIT_NOFILE, &original_limit);
+
+    CATCH_REQUIRE_FALSE(was_thrown);
+    CATCH_REQUIRE(batch.size() == 1);
+    CATCH_REQUIRE(batch.front().is_connected());
+    CATCH_REQUIRE(next_ec == std::errc::too_many_files_open);
+
+    for (int fd : client_fds) ::close(fd);
+}
+
+CATCH_TEST_CASE("[yonaa::acceptor] Acceptor listens at every resolved endpoint", "[net]") {
+    yonaa::acceptor acceptor;
+    std::error_code ec;
+
+    // Note: Hosts without IPv6 only get the IPv4 loopback address.
+    auto endpoints    = yonaa::resolve(yonaa::loopback_address, service);
+    auto v6_endpoints = yonaa::resolve(yonaa::loopback_address_v6, service, ec);
+    endpoints.insert(endpoints.end(), v6_endpoints.begin(), v6_endpoints.end());
+
+    ec.clear();
+    acceptor.open(endpoints, ec, yonaa::acceptor_config::reuse_address);
+    CATCH_REQUIRE_FALSE(ec);
+
+    // There should be a socket for each endpoint...
+    CATCH_REQUIRE(acceptor.native_sockets().size() == endpoints.size());
+    CATCH_REQUIRE(acceptor.local_endpoints().size() == endpoints.size());
+    CATCH_REQUIRE(acceptor.native_socket() == acceptor.native_sockets().front());
+    CATCH_REQUIRE(acceptor.local_endpoint() == acceptor.local_endpoints().front());
+
+    // ... and connections to any of them should be accepted in a single batch.
+    std::vector<int> client_fds;
+    for (const yonaa::endpoint &local_endpoint : acceptor.local_endpoints()) {
+        int client_fd = ::socket(local_endpoint.family(), SOCK_STREAM, 0);
+        CATCH_REQUIRE(::connect(client_fd, local_endpoint.data(), local_endpoint.size()) == 0);
+        client_fds.push_back(client_fd);
+    }
+
+    CATCH_REQUIRE(acceptor.has_pending_connection());
+
+    auto batch = acceptor.accept_batch(16, ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(batch.size() == endpoints.size());
+
+    for (int fd : client_fds) ::close(fd);
+
+    // Once closed, the acceptor should not be bound to anything.
+    acceptor.close();
+    CATCH_REQUIRE(acceptor.native_sockets().empty());
+    CATCH_REQUIRE(acceptor.local_endpoints().empty());
+}
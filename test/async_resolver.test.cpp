@@ -0,0 +1,143 @@
+#include "yonaa/async_resolver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+#include "yonaa/addresses.hpp"
+
+/// @brief The result of an asynchronous resolution, as passed to its handler.
+struct resolve_outcome {
+    yonaa::resolve_result result;
+    std::error_code ec;
+};
+
+/// @brief Return a handler that fulfills the given promise with the outcome that it is called with.
+static yonaa::async_resolver::resolve_handler fulfill(std::promise<resolve_outcome> &promise) {
+    return [&promise](yonaa::resolve_result result, std::error_code ec) {
+        promise.set_value({std::move(result), ec});
+    };
+}
+
+/// @brief Occupy the only thread of a resolver for a while, by resolving a name with a handler
+/// that sleeps, so that the requests made after it have to wait.
+static void occupy_resolver(yonaa::async_resolver &resolver, std::promise<void> &started) {
+    resolver.async_resolve(yonaa::loopback_address, "5000", [&](auto, auto) {
+        started.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    });
+    started.get_future().wait();
+}
+
+CATCH_TEST_CASE("[yonaa::async_resolver] Names are resolved without blocking", "[net]") {
+    yonaa::async_resolver resolver;
+
+    // Several requests should be resolved at once, with the same results as resolve()...
+    std::vector<std::promise<resolve_outcome>> promises(8);
+    for (auto &promise : promises) {
+        resolver.async_resolve(yonaa::loopback_address, "5000", fulfill(promise));
+    }
+
+    auto expected = yonaa::resolve(yonaa::loopback_address, "5000");
+    for (auto &promise : promises) {
+        resolve_outcome outcome = promise.get_future().get();
+        CATCH_REQUIRE_FALSE(outcome.ec);
+        CATCH_REQUIRE(outcome.result == expected);
+    }
+
+    // ... and failures should be passed to the handler.
+    std::promise<resolve_outcome> failure;
+    resolver.async_resolve(yonaa::loopback_address, "not-a-service", fulfill(failure));
+    CATCH_REQUIRE(failure.get_future().get().ec);
+}
+
+CATCH_TEST_CASE("[yonaa::async_resolver] Handlers are called through their executor", "[net]") {
+    yonaa::async_resolver resolver;
+
+    std::mutex tasks_mutex;
+    std::vector<std::function<void()>> tasks;
+    auto post = [&](std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        tasks.push_back(std::move(task));
+    };
+
+    std::atomic<bool> is_called{false};
+    resolver.async_resolve(
+        yonaa::loopback_address,
+        "5000",
+        [&](auto, auto) { is_called = true; },
+        std::chrono::seconds(5),
+        post);
+
+    auto posted_count = [&] {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        return tasks.size();
+    };
+    while (posted_count() == 0) { std::this_thread::yield(); }
+
+    // The handler should only run once the posted task does
+    CATCH_REQUIRE_FALSE(is_called);
+    CATCH_REQUIRE(resolver.pending_requests() == 0);
+
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    CATCH_REQUIRE(tasks.size() == 1);
+    tasks.front()();
+    CATCH_REQUIRE(is_called);
+}
+
+CATCH_TEST_CASE("[yonaa::async_resolver] Requests can time out or be canceled", "[net]") {
+    yonaa::async_resolver_config config;
+    config.thread_count         = 1;
+    config.max_pending_requests = 2;
+    yonaa::async_resolver resolver(config);
+
+    std::promise<void> started;
+    occupy_resolver(resolver, started);
+
+    // While the only thread is busy, a request should time out...
+    std::promise<resolve_outcome> timed_out;
+    resolver.async_resolve(
+        yonaa::loopback_address, "5000", fulfill(timed_out), std::chrono::milliseconds(50));
+    CATCH_REQUIRE(timed_out.get_future().get().ec == std::errc::timed_out);
+
+    // ... or be canceled, but only once...
+    std::promise<resolve_outcome> canceled;
+    auto id = resolver.async_resolve(yonaa::loopback_address, "5000", fulfill(canceled));
+    CATCH_REQUIRE(resolver.cancel(id));
+    CATCH_REQUIRE(canceled.get_future().get().ec == std::errc::operation_canceled);
+    CATCH_REQUIRE_FALSE(resolver.cancel(id));
+
+    // ... and requests beyond the limit should be turned away.
+    std::promise<resolve_outcome> first, second, rejected;
+    resolver.async_resolve(yonaa::loopback_address, "5000", fulfill(first));
+    resolver.async_resolve(yonaa::loopback_address, "5000", fulfill(second));
+    resolver.async_resolve(yonaa::loopback_address, "5000", fulfill(rejected));
+    CATCH_REQUIRE(
+        rejected.get_future().get().ec == std::errc::resource_unavailable_try_again);
+
+    CATCH_REQUIRE_FALSE(first.get_future().get().ec);
+    CATCH_REQUIRE_FALSE(second.get_future().get().ec);
+}
+
+CATCH_TEST_CASE(
+    "[yonaa::async_resolver] Unfinished requests are canceled on destruction", "[net]") {
+    std::promise<resolve_outcome> canceled;
+    {
+        yonaa::async_resolver_config config;
+        config.thread_count = 1;
+        yonaa::async_resolver resolver(config);
+
+        std::promise<void> started;
+        occupy_resolver(resolver, started);
+        resolver.async_resolve(yonaa::loopback_address, "5000", fulfill(canceled));
+    }
+
+    CATCH_REQUIRE(canceled.get_future().get().ec == std::errc::operation_canceled);
+}
@@ -0,0 +1,131 @@
+#include "yonaa/buffer.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+static const std::string small_data("Hello!\n");
+static const std::string large_data(4096, 'x');
+
+CATCH_TEST_CASE("[yonaa::buffer] buffer", "[net]") {
+    CATCH_SECTION("Small buffers are stored inline, and large ones are not") {
+        yonaa::buffer small(small_data);
+        CATCH_REQUIRE(small.str() == small_data);
+        CATCH_REQUIRE(small.capacity() == yonaa::buffer::inline_capacity);
+
+        yonaa::buffer large(large_data);
+        CATCH_REQUIRE(large.str() == large_data);
+        CATCH_REQUIRE(large.capacity() >= large_data.size());
+    }
+
+    CATCH_SECTION("Copies and moves keep the data") {
+        for (const auto &data : {small_data, large_data}) {
+            yonaa::buffer original(data);
+
+            yonaa::buffer copy(original);
+            CATCH_REQUIRE(copy == original);
+
+            yonaa::buffer assigned(small_data);
+            assigned = original;
+            CATCH_REQUIRE(assigned == original);
+
+            // Moved-from buffers are left empty...
+            const char *storage = original.data();
+            yonaa::buffer moved(std::move(original));
+            CATCH_REQUIRE(moved.str() == data);
+            CATCH_REQUIRE(original.is_empty());
+
+            // ... and large buffers hand over their storage rather than copying it.
+            if (data.size() > yonaa::buffer::inline_capacity) {
+                CATCH_REQUIRE(moved.data() == storage);
+            }
+
+            original = std::move(moved);
+            CATCH_REQUIRE(original.str() == data);
+        }
+    }
+
+    CATCH_SECTION("Buffers created with a size are zeroed") {
+        for (size_t size : {small_data.size(), large_data.size()}) {
+            yonaa::buffer b(size);
+            CATCH_REQUIRE(b.size() == size);
+            CATCH_REQUIRE(b == yonaa::buffer(std::string(size, '\0')));
+        }
+    }
+
+    CATCH_SECTION("Resizing keeps the data, and zeroes any bytes added") {
+        yonaa::buffer b(small_data);
+        b.resize(large_data.size());
+        CATCH_REQUIRE(b.size() == large_data.size());
+        CATCH_REQUIRE(std::string(b.data(), small_data.size()) == small_data);
+        CATCH_REQUIRE(b.data()[large_data.size() - 1] == 0);
+
+        b.resize_uninitialized(3);
+        CATCH_REQUIRE(b.str() == small_data.substr(0, 3));
+
+        b.reserve(1 << 16);
+        CATCH_REQUIRE(b.capacity() >= (size_t)1 << 16);
+        CATCH_REQUIRE(b.str() == small_data.substr(0, 3));
+    }
+
+    CATCH_SECTION("Buffers are equal only if they contain the same data") {
+        CATCH_REQUIRE(yonaa::buffer(small_data) == yonaa::buffer(small_data));
+        CATCH_REQUIRE_FALSE(yonaa::buffer(small_data) == yonaa::buffer("Hello?\n"));
+        CATCH_REQUIRE_FALSE(yonaa::buffer(small_data) == yonaa::buffer(large_data));
+        CATCH_REQUIRE(yonaa::buffer() == yonaa::buffer());
+    }
+}
+
+CATCH_TEST_CASE("[yonaa::buffer_view] buffer_view", "[net]") {
+    CATCH_SECTION("Views refer to data without copying it") {
+        yonaa::buffer b(large_data);
+        yonaa::buffer_view from_buffer(b);
+        CATCH_REQUIRE(from_buffer.data() == b.data());
+        CATCH_REQUIRE(from_buffer.size() == b.size());
+
+        yonaa::buffer_view from_string(small_data);
+        CATCH_REQUIRE(from_string.data() == small_data.data());
+        CATCH_REQUIRE(from_string.str() == small_data);
+
+        std::string_view string_view(small_data);
+        CATCH_REQUIRE(yonaa::buffer_view(string_view).data() == small_data.data());
+
+        // Arrays leave out their terminator, as with buffer...
+        CATCH_REQUIRE(yonaa::buffer_view("Hello!\n") == yonaa::buffer("Hello!\n"));
+
+        // ... and a view can be copied into a buffer of its own.
+        yonaa::buffer copy(from_string);
+        CATCH_REQUIRE(copy.data() != small_data.data());
+        CATCH_REQUIRE(copy.str() == small_data);
+    }
+
+    CATCH_SECTION("Views are equal only if they refer to the same data") {
+        CATCH_REQUIRE(yonaa::buffer_view(small_data) == yonaa::buffer(small_data));
+        CATCH_REQUIRE_FALSE(yonaa::buffer_view(small_data) == yonaa::buffer_view("Hello?\n"));
+        CATCH_REQUIRE(yonaa::buffer_view() == yonaa::buffer());
+    }
+}
+
+CATCH_TEST_CASE("[yonaa::buffer_sequence] buffer_sequence", "[net]") {
+    std::vector<yonaa::buffer> buffers = {yonaa::buffer(small_data), yonaa::buffer(large_data)};
+    std::vector<yonaa::buffer_view> views(buffers.begin(), buffers.end());
+
+    // Sequences of buffers and of views should refer to the same data, in order...
+    for (yonaa::buffer_sequence sequence :
+         {yonaa::buffer_sequence(buffers), yonaa::buffer_sequence(views)}) {
+        CATCH_REQUIRE(sequence.size() == 2);
+        CATCH_REQUIRE(sequence[0].data() == buffers[0].data());
+        CATCH_REQUIRE(sequence[1].data() == buffers[1].data());
+        CATCH_REQUIRE(sequence.total_size() == small_data.size() + large_data.size());
+    }
+
+    // ... and so should a sequence given as a list.
+    auto list_size = [](yonaa::buffer_sequence sequence) { return sequence.total_size(); };
+    size_t expected_size = small_data.size() + 3 + large_data.size();
+    CATCH_REQUIRE(list_size({small_data, "abc", buffers[1]}) == expected_size);
+    CATCH_REQUIRE(yonaa::buffer_sequence().empty());
+}
@@ -0,0 +1,70 @@
+#include "yonaa/buffer_pool.hpp"
+
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+#include "yonaa/buffer.hpp"
+
+#if defined(YONAA_ENABLE_BUFFER_POOL)
+CATCH_TEST_CASE("[yonaa::buffer_pool] buffer_pool", "[net]") {
+    yonaa::trim_buffer_pool();
+
+    CATCH_SECTION("released storage is reused by the same thread") {
+        { yonaa::buffer warm_up(1000); }
+        auto before = yonaa::get_buffer_pool_stats();
+
+        for (int i = 0; i < 100; i++) { yonaa::buffer b(1000); }
+        auto after = yonaa::get_buffer_pool_stats();
+
+        CATCH_REQUIRE(after.hits - before.hits == 100);
+        CATCH_REQUIRE(after.misses == before.misses);
+        CATCH_REQUIRE(after.bytes_held >= 1024);
+    }
+
+    CATCH_SECTION("storage released by one thread is reused by another") {
+        std::thread([] {
+            std::vector<yonaa::buffer> buffers;
+            for (int i = 0; i < 16; i++) buffers.emplace_back(4096);
+        }).join();
+
+        auto before = yonaa::get_buffer_pool_stats();
+        CATCH_REQUIRE(before.bytes_held >= 16 * 4096);
+
+        std::thread([] { yonaa::buffer b(4096); }).join();
+        auto after = yonaa::get_buffer_pool_stats();
+
+        CATCH_REQUIRE(after.hits - before.hits == 1);
+        CATCH_REQUIRE(after.misses == before.misses);
+    }
+
+    CATCH_SECTION("storage beyond the limit is returned to the system") {
+        yonaa::set_buffer_pool_limit(64 * 1024);
+
+        std::thread([] {
+            std::vector<yonaa::buffer> buffers;
+            for (int i = 0; i < 64; i++) buffers.emplace_back(8192);
+        }).join();
+
+        auto stats = yonaa::get_buffer_pool_stats();
+        CATCH_REQUIRE(stats.max_bytes_held == 64 * 1024);
+        CATCH_REQUIRE(stats.bytes_held <= 64 * 1024);
+
+        yonaa::set_buffer_pool_limit(64 * 1024 * 1024);
+    }
+
+    CATCH_SECTION("large buffers bypass the pool") {
+        auto before = yonaa::get_buffer_pool_stats();
+        { yonaa::buffer b(1024 * 1024); }
+        auto after = yonaa::get_buffer_pool_stats();
+
+        CATCH_REQUIRE(after.misses - before.misses == 1);
+        CATCH_REQUIRE(after.bytes_held == before.bytes_held);
+    }
+
+    yonaa::trim_buffer_pool();
+    CATCH_REQUIRE(yonaa::get_buffer_pool_stats().bytes_held == 0);
+}
+#endif
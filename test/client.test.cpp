@@ -1,9 +1,16 @@
 #include "yonaa/client.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
 #define CATCH_CONFIG_PREFIX_ALL
 #include <catch2/catch_test_macros.hpp>
 
 #include "yonaa/addresses.hpp"
+#include "yonaa/server.hpp"
 
 static const std::string hostname(yonaa::loopback_address);
 static const std::string service("5000");
@@ -11,8 +18,8 @@ static const yonaa::buffer message("Hello!\n");
 
 static yonaa::buffer response_buffer;
 
-void on_data_receive(const yonaa::buffer &data) {
-    response_buffer = data;
+void on_data_receive(yonaa::buffer_view data) {
+    response_buffer = yonaa::buffer(data);
 }
 
 CATCH_TEST_CASE("[yonaa::client] Client test", "[yonaa]") {
@@ -57,3 +64,100 @@ CATCH_TEST_CASE("[yonaa::client] Client test", "[yonaa]") {
 
     if (server_thread.joinable()) server_thread.join();
 }
+
+CATCH_TEST_CASE("[yonaa::client] Data is delivered as soon as it arrives", "[yonaa]") {
+    // Start an echo server
+    yonaa::server server(5012);
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler(
+        [&](yonaa::client_id id, yonaa::buffer_view data) { server.message_client(data, id); });
+    server.run();
+
+    std::promise<void> connected, disconnected;
+    std::atomic<size_t> bytes_received{0};
+    std::atomic<int> disconnect_count{0};
+
+    yonaa::client client;
+    client.set_connect_handler([&]() { connected.set_value(); });
+    client.set_disconnect_handler([&]() {
+        if (disconnect_count++ == 0) disconnected.set_value();
+    });
+    client.set_data_receive_handler(
+        [&](yonaa::buffer_view data) { bytes_received += data.size(); });
+
+    client.connect(hostname, "5012");
+    connected.get_future().wait();
+    CATCH_REQUIRE(client.is_running());
+
+    // Each echo should be delivered without waiting on the client to poll for it...
+    for (size_t i = 1; i <= 10; i++) {
+        client.send_message(message);
+
+        auto start = std::chrono::steady_clock::now();
+        while (bytes_received < i * message.size() &&
+               std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+            std::this_thread::yield();
+        }
+        CATCH_REQUIRE(bytes_received == i * message.size());
+    }
+
+    // ... and disconnecting should wake the client right away, and only be reported once.
+    client.disconnect();
+    auto disconnected_future = disconnected.get_future();
+    CATCH_REQUIRE(
+        disconnected_future.wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    CATCH_REQUIRE(disconnect_count == 1);
+    CATCH_REQUIRE_FALSE(client.is_connected());
+    CATCH_REQUIRE_FALSE(client.is_running());
+
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::client] Messages can be sent from any thread", "[yonaa]") {
+    const size_t thread_count  = 4;
+    const size_t message_count = 200;
+
+    // Start an echo server
+    yonaa::server server(5024);
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler(
+        [&](yonaa::client_id id, yonaa::buffer_view data) { server.message_client(data, id); });
+    server.run();
+
+    std::atomic<size_t> bytes_received{0};
+
+    yonaa::client client;
+    client.set_connect_handler([]() {});
+    client.set_disconnect_handler([]() {});
+    client.set_data_receive_handler(
+        [&](yonaa::buffer_view data) { bytes_received += data.size(); });
+
+    // Messages sent before the client connects wait for the connection...
+    client.send_message(message);
+    client.connect(hostname, "5024");
+
+    // ... and messages sent while the network thread is receiving are handed over to it.
+    std::vector<std::thread> senders;
+    for (size_t i = 0; i < thread_count; i++) {
+        senders.emplace_back([&]() {
+            for (size_t j = 0; j < message_count; j++) client.send_message(message);
+        });
+    }
+    for (auto &sender : senders) sender.join();
+
+    size_t expected_size = (1 + thread_count * message_count) * message.size();
+    auto start           = std::chrono::steady_clock::now();
+    while (bytes_received < expected_size &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::yield();
+    }
+    CATCH_REQUIRE(bytes_received == expected_size);
+    CATCH_REQUIRE(client.is_connected());
+
+    client.disconnect();
+    server.stop();
+}
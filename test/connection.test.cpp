@@ -1,8 +1,19 @@
 #include "yonaa/connection.hpp"
 
+#include <sys/socket.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
 #define CATCH_CONFIG_PREFIX_ALL
 #include <catch2/catch_test_macros.hpp>
 
+#include "yonaa/acceptor.hpp"
+#include "yonaa/addresses.hpp"
+
 static const std::string hostname("tcpbin.com");
 static const std::string service("4242");
 static const yonaa::buffer message("Hello!\n");
@@ -84,3 +95,216 @@ CATCH_TEST_CASE("[yonaa::connection] Connection can be opened with valid endpoin
         CATCH_REQUIRE(buffer.size() > 0);
     }
 }
+
+CATCH_TEST_CASE("[yonaa::connection] Buffer sequences are gathered and scattered", "[net]") {
+    int pair[2];
+    CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+
+    auto sender   = yonaa::connection::from_native_socket(pair[0], yonaa::endpoint());
+    auto receiver = yonaa::connection::from_native_socket(pair[1], yonaa::endpoint());
+    std::error_code ec;
+
+    CATCH_SECTION("Gathered data arrives in order") {
+        sender.send({yonaa::buffer("head:"), yonaa::buffer(), yonaa::buffer("body")}, ec);
+        CATCH_REQUIRE_FALSE(ec);
+
+        // The data should be scattered across the receiving buffers in order...
+        std::vector<yonaa::buffer> parts = {yonaa::buffer(5), yonaa::buffer(4)};
+        CATCH_REQUIRE(receiver.receive(parts, ec) == 9);
+        CATCH_REQUIRE_FALSE(ec);
+        CATCH_REQUIRE(parts[0].str() == "head:");
+        CATCH_REQUIRE(parts[1].str() == "body");
+
+        // ... and an empty sequence should not be sent.
+        sender.send(std::vector<yonaa::buffer>(), ec);
+        CATCH_REQUIRE(ec);
+    }
+
+    CATCH_SECTION("Partial sends resume from the right offset") {
+        std::string head(1000, 'h');
+        std::string body(1 << 20, 'b');
+        for (size_t i = 0; i < body.size(); i++) body[i] = (char)('a' + i % 26);
+        std::vector<yonaa::buffer> data = {yonaa::buffer(head), yonaa::buffer(body)};
+
+        std::string received;
+        size_t sent = 0;
+        while (sent < head.size() + body.size()) {
+            sent += sender.try_send(data, sent, ec);
+            CATCH_REQUIRE_FALSE(ec);
+
+            while (receiver.has_data_available()) { received += receiver.receive().str(); }
+        }
+        while (received.size() < sent) { received += receiver.receive().str(); }
+
+        CATCH_REQUIRE(received == head + body);
+    }
+}
+
+CATCH_TEST_CASE("[yonaa::connection] Data can be received into caller-owned storage", "[net]") {
+    int pair[2];
+    CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+
+    auto sender   = yonaa::connection::from_native_socket(pair[0], yonaa::endpoint());
+    auto receiver = yonaa::connection::from_native_socket(pair[1], yonaa::endpoint());
+    std::error_code ec;
+
+    sender.send(message, ec);
+    CATCH_REQUIRE_FALSE(ec);
+
+    // Only the bytes received should be written, and the buffer should keep its size...
+    yonaa::buffer storage(64);
+    storage.zero();
+    CATCH_REQUIRE(receiver.receive_into(storage, ec) == message.size());
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(storage.size() == 64);
+    CATCH_REQUIRE(std::string(storage.data(), message.size()) == message.str());
+    CATCH_REQUIRE(storage.data()[message.size()] == 0);
+
+    // ... and a hang-up should close the connection.
+    sender.disconnect();
+    CATCH_REQUIRE(receiver.receive_into(storage.data(), storage.size(), ec) == 0);
+    CATCH_REQUIRE_FALSE(receiver.is_connected());
+}
+
+CATCH_TEST_CASE("[yonaa::connection] Data can be sent from views", "[net]") {
+    int pair[2];
+    CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+
+    auto sender   = yonaa::connection::from_native_socket(pair[0], yonaa::endpoint());
+    auto receiver = yonaa::connection::from_native_socket(pair[1], yonaa::endpoint());
+    std::error_code ec;
+
+    // Strings and views of them should be sent without being copied into buffers first...
+    std::string head("head:");
+    std::string_view body("body");
+    sender.send(head, ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(sender.try_send(body, 0, ec) == body.size());
+    CATCH_REQUIRE_FALSE(ec);
+
+    // ... and so should sequences that mix them.
+    sender.send({head, body, message}, ec);
+    CATCH_REQUIRE_FALSE(ec);
+
+    std::string expected = "head:body" + head + std::string(body) + message.str();
+    std::string received;
+    while (received.size() < expected.size()) { received += receiver.receive().str(); }
+
+    CATCH_REQUIRE(received == expected);
+}
+
+CATCH_TEST_CASE("[yonaa::connection] Socket options can be set and read back", "[net]") {
+    yonaa::acceptor acceptor;
+    acceptor.open(yonaa::resolve(yonaa::loopback_address, "5006"));
+
+    yonaa::connection conn;
+    std::error_code ec;
+
+    // Options cannot be set before the connection is established...
+    conn.set_options(yonaa::connection_options(), ec);
+    CATCH_REQUIRE(ec);
+
+    ec.clear();
+    conn.connect(yonaa::resolve(yonaa::loopback_address, "5006"), ec);
+    CATCH_REQUIRE_FALSE(ec);
+
+    // ... and afterwards, the options set should be the ones in effect...
+    yonaa::connection_options options;
+    options.no_delay               = true;
+    options.send_buffer_size       = 64 * 1024;
+    options.not_sent_low_watermark = 16 * 1024;
+    options.keep_alive             = true;
+    options.keep_alive_idle        = std::chrono::seconds(30);
+    options.keep_alive_interval    = std::chrono::seconds(5);
+    options.keep_alive_count       = 3;
+
+    conn.set_options(options, ec);
+    CATCH_REQUIRE_FALSE(ec);
+
+    yonaa::connection_options effective = conn.options(ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(effective.no_delay == true);
+    CATCH_REQUIRE(effective.send_buffer_size == options.send_buffer_size);
+    CATCH_REQUIRE(effective.not_sent_low_watermark == options.not_sent_low_watermark);
+    CATCH_REQUIRE(effective.keep_alive == true);
+    CATCH_REQUIRE(effective.keep_alive_idle == options.keep_alive_idle);
+    CATCH_REQUIRE(effective.keep_alive_interval == options.keep_alive_interval);
+    CATCH_REQUIRE(effective.keep_alive_count == options.keep_alive_count);
+
+    // ... while the ones left unset should be untouched...
+    CATCH_REQUIRE(effective.busy_poll == std::chrono::microseconds(0));
+
+    // ... and setting the options in effect again should not change any of them...
+    conn.set_options(effective, ec);
+    CATCH_REQUIRE_FALSE(ec);
+
+    yonaa::connection_options round_trip = conn.options(ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(round_trip.send_buffer_size == effective.send_buffer_size);
+    CATCH_REQUIRE(round_trip.receive_buffer_size == effective.receive_buffer_size);
+
+    // ... though options that were turned on can be turned back off.
+    yonaa::connection_options off;
+    off.no_delay   = false;
+    off.keep_alive = false;
+
+    conn.set_options(off, ec);
+    CATCH_REQUIRE_FALSE(ec);
+
+    effective = conn.options(ec);
+    CATCH_REQUIRE_FALSE(ec);
+    CATCH_REQUIRE(effective.no_delay == false);
+    CATCH_REQUIRE(effective.keep_alive == false);
+    CATCH_REQUIRE(effective.send_buffer_size == options.send_buffer_size);
+}
+
+CATCH_TEST_CASE("[yonaa::connection] Connecting can time out", "[net]") {
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, "5009");
+
+    // A listener whose backlog is full drops new connection attempts, which then stall
+    yonaa::acceptor_options options;
+    options.backlog = 0;
+
+    yonaa::acceptor acceptor;
+    acceptor.open(endpoints, options);
+
+    yonaa::connection filler;
+    filler.connect(endpoints);
+
+    yonaa::connection conn;
+    std::error_code ec;
+
+    auto start = std::chrono::steady_clock::now();
+    conn.connect(endpoints, std::chrono::milliseconds(100), ec);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CATCH_REQUIRE(ec == std::errc::timed_out);
+    CATCH_REQUIRE_FALSE(conn.is_connected());
+    CATCH_REQUIRE(elapsed >= std::chrono::milliseconds(100));
+    CATCH_REQUIRE(elapsed < std::chrono::seconds(1));
+}
+
+CATCH_TEST_CASE("[yonaa::connection] Local endpoint can be looked up from any thread", "[net]") {
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, "5025");
+
+    yonaa::acceptor acceptor;
+    acceptor.open(endpoints);
+
+    yonaa::connection client;
+    client.connect(endpoints);
+
+    // Accepted connections look their local endpoint up on first use
+    yonaa::connection conn = acceptor.accept();
+
+    std::vector<yonaa::endpoint> results(4);
+    std::vector<std::thread> threads;
+    for (auto &result : results) {
+        threads.emplace_back([&conn, &result] { result = conn.local_endpoint(); });
+    }
+    for (auto &thread : threads) thread.join();
+
+    for (const auto &result : results) {
+        CATCH_REQUIRE(result.addr() == yonaa::loopback_address);
+        CATCH_REQUIRE(result.port() == "5025");
+    }
+}
@@ -0,0 +1,153 @@
+#include "yonaa/connector.hpp"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+#include "yonaa/acceptor.hpp"
+#include "yonaa/addresses.hpp"
+
+static const yonaa::resolve_result live_endpoints =
+    yonaa::resolve(yonaa::loopback_address, "5010");
+static const yonaa::resolve_result stalled_endpoints =
+    yonaa::resolve(yonaa::loopback_address, "5011");
+
+/// @brief The result of an asynchronous connection, as passed to its handler.
+struct connect_outcome {
+    yonaa::connection conn;
+    std::error_code ec;
+};
+
+/// @brief Return a handler that fulfills the given promise with the outcome that it is called with.
+static yonaa::connector::connect_handler fulfill(std::promise<connect_outcome> &promise) {
+    return [&promise](yonaa::connection conn, std::error_code ec) {
+        promise.set_value({std::move(conn), ec});
+    };
+}
+
+/// @brief Open an acceptor whose backlog is full, so that new connection attempts to it stall.
+static void open_stalled_acceptor(yonaa::acceptor &acceptor, yonaa::connection &filler) {
+    yonaa::acceptor_options options;
+    options.backlog = 0;
+
+    acceptor.open(stalled_endpoints, options);
+    filler.connect(stalled_endpoints);
+}
+
+CATCH_TEST_CASE("[yonaa::connector] Connections are established without blocking", "[net]") {
+    yonaa::acceptor_options options;
+    options.backlog = 1024;
+
+    yonaa::acceptor acceptor;
+    acceptor.open(live_endpoints, options);
+
+    yonaa::connector connector;
+
+    // Many connections should be brought up at once...
+    std::vector<std::promise<connect_outcome>> promises(256);
+    for (auto &promise : promises) connector.async_connect(live_endpoints, fulfill(promise));
+
+    for (auto &promise : promises) {
+        connect_outcome outcome = promise.get_future().get();
+        CATCH_REQUIRE_FALSE(outcome.ec);
+        CATCH_REQUIRE(outcome.conn.is_connected());
+        CATCH_REQUIRE(outcome.conn.remote_endpoint() == live_endpoints.front());
+    }
+    CATCH_REQUIRE(connector.pending_requests() == 0);
+
+    // ... and failures should be passed to the handler.
+    acceptor.close();
+
+    std::promise<connect_outcome> refused;
+    connector.async_connect(live_endpoints, fulfill(refused));
+    CATCH_REQUIRE(refused.get_future().get().ec == std::errc::connection_refused);
+}
+
+CATCH_TEST_CASE("[yonaa::connector] Handlers are called through their executor", "[net]") {
+    yonaa::acceptor acceptor;
+    acceptor.open(live_endpoints);
+
+    yonaa::connector connector;
+
+    std::mutex tasks_mutex;
+    std::vector<std::function<void()>> tasks;
+    std::promise<void> posted;
+    auto post = [&](std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        tasks.push_back(std::move(task));
+        posted.set_value();
+    };
+
+    std::promise<connect_outcome> promise;
+    connector.async_connect(live_endpoints, fulfill(promise), yonaa::connect_options(), post);
+    posted.get_future().wait();
+
+    // The handler should only run once the posted task does
+    auto future = promise.get_future();
+    CATCH_REQUIRE(future.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready);
+
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    CATCH_REQUIRE(tasks.size() == 1);
+    tasks.front()();
+
+    connect_outcome outcome = future.get();
+    CATCH_REQUIRE_FALSE(outcome.ec);
+    CATCH_REQUIRE(outcome.conn.is_connected());
+}
+
+CATCH_TEST_CASE("[yonaa::connector] Requests can time out or be canceled", "[net]") {
+    yonaa::acceptor acceptor;
+    yonaa::connection filler;
+    open_stalled_acceptor(acceptor, filler);
+
+    yonaa::connector_config config;
+    config.max_pending_requests = 2;
+    yonaa::connector connector(config);
+
+    // A stalled request should time out...
+    yonaa::connect_options options;
+    options.timeout = std::chrono::milliseconds(50);
+
+    std::promise<connect_outcome> timed_out;
+    connector.async_connect(stalled_endpoints, fulfill(timed_out), options);
+    CATCH_REQUIRE(timed_out.get_future().get().ec == std::errc::timed_out);
+
+    // ... or be canceled, but only once...
+    std::promise<connect_outcome> canceled;
+    auto id = connector.async_connect(stalled_endpoints, fulfill(canceled));
+    CATCH_REQUIRE(connector.cancel(id));
+    CATCH_REQUIRE(canceled.get_future().get().ec == std::errc::operation_canceled);
+    CATCH_REQUIRE_FALSE(connector.cancel(id));
+
+    // ... and requests beyond the limit should be turned away.
+    std::promise<connect_outcome> first, second, rejected;
+    auto first_id  = connector.async_connect(stalled_endpoints, fulfill(first));
+    auto second_id = connector.async_connect(stalled_endpoints, fulfill(second));
+    connector.async_connect(stalled_endpoints, fulfill(rejected));
+    CATCH_REQUIRE(
+        rejected.get_future().get().ec == std::errc::resource_unavailable_try_again);
+
+    connector.cancel(first_id);
+    connector.cancel(second_id);
+    CATCH_REQUIRE(first.get_future().get().ec == std::errc::operation_canceled);
+    CATCH_REQUIRE(second.get_future().get().ec == std::errc::operation_canceled);
+}
+
+CATCH_TEST_CASE("[yonaa::connector] Unfinished requests are canceled on destruction", "[net]") {
+    yonaa::acceptor acceptor;
+    yonaa::connection filler;
+    open_stalled_acceptor(acceptor, filler);
+
+    std::promise<connect_outcome> canceled;
+    {
+        yonaa::connector connector;
+        connector.async_connect(stalled_endpoints, fulfill(canceled));
+    }
+
+    CATCH_REQUIRE(canceled.get_future().get().ec == std::errc::operation_canceled);
+}
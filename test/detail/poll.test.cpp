@@ -1,5 +1,8 @@
 #include "yonaa/detail/poll.hpp"
 
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <thread>
 
 #define CATCH_CONFIG_PREFIX_ALL
@@ -150,3 +153,109 @@ CATCH_TEST_CASE("[yonaa::detail::poll] poll_group", "[net]") {
     CATCH_REQUIRE(pg.size() == 0);
     // ---------------------------------------------------------------------------------------------
 }
+
+CATCH_TEST_CASE("[yonaa::detail::poll] poll_group backends", "[net]") {
+    using yonaa::detail::poll_backend;
+
+    for (auto backend : {poll_backend::poll, poll_backend::epoll}) {
+        yonaa::detail::poll_group pg(yonaa::detail::socket_status::readable, backend);
+
+        int pair_1[2];
+        int pair_2[2];
+        CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair_1) == 0);
+        CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair_2) == 0);
+
+        pg.add_socket(pair_1[0]);
+        pg.add_socket(pair_2[0]);
+        CATCH_REQUIRE(pg.size() == 2);
+
+        // Idle sockets are not reported...
+        CATCH_REQUIRE(pg.poll().empty());
+
+        // ... but sockets with data waiting to be read are...
+        CATCH_REQUIRE(::write(pair_1[1], "Hello!\n", 7) == 7);
+
+        auto pr = pg.poll(1000);
+        CATCH_REQUIRE(pr.size() == 1);
+        CATCH_REQUIRE(pr[0].socket_fd == pair_1[0]);
+        CATCH_REQUIRE(pr[0].status & yonaa::detail::socket_status::readable);
+
+        // ... and are reported again for as long as the data goes unread.
+        CATCH_REQUIRE(pg.poll().size() == 1);
+
+        // Removed sockets are no longer reported...
+        pg.remove_socket(pair_1[0]);
+        CATCH_REQUIRE(pg.size() == 1);
+        CATCH_REQUIRE(pg.poll().empty());
+
+        // ... and can be added again.
+        pg.add_socket(pair_1[0]);
+        CATCH_REQUIRE(pg.size() == 2);
+        CATCH_REQUIRE(pg.poll(1000).size() == 1);
+
+        for (int fd : {pair_1[0], pair_1[1], pair_2[0], pair_2[1]}) ::close(fd);
+    }
+}
+
+CATCH_TEST_CASE("[yonaa::detail::poll] poll_group::modify_socket()", "[net]") {
+    using yonaa::detail::poll_backend;
+    using yonaa::detail::socket_status;
+
+    for (auto backend : {poll_backend::poll, poll_backend::epoll}) {
+        yonaa::detail::poll_group pg(socket_status::readable, backend);
+
+        int pair[2];
+        CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+        pg.add_socket(pair[0]);
+
+        // An idle socket is writable, but that is not being watched for...
+        CATCH_REQUIRE(pg.poll().empty());
+
+        // ... until it is...
+        pg.modify_socket(pair[0], socket_status::readable | socket_status::writable);
+        auto pr = pg.poll(1000);
+        CATCH_REQUIRE(pr.size() == 1);
+        CATCH_REQUIRE(pr[0].socket_fd == pair[0]);
+        CATCH_REQUIRE(pr[0].status & socket_status::writable);
+        CATCH_REQUIRE_FALSE(pr[0].status & socket_status::readable);
+
+        // ... and stops being reported once it no longer is.
+        pg.modify_socket(pair[0], socket_status::readable);
+        CATCH_REQUIRE(pg.poll().empty());
+
+        CATCH_REQUIRE(::write(pair[1], "Hello!\n", 7) == 7);
+        pr = pg.poll(1000);
+        CATCH_REQUIRE(pr.size() == 1);
+        CATCH_REQUIRE(pr[0].status & socket_status::readable);
+        CATCH_REQUIRE_FALSE(pr[0].status & socket_status::writable);
+
+        pg.remove_socket(pair[0]);
+        ::close(pair[0]);
+        ::close(pair[1]);
+    }
+}
+
+#if defined(YONAA_HAS_EPOLL)
+CATCH_TEST_CASE("[yonaa::detail::poll] poll_group edge-triggered mode", "[net]") {
+    yonaa::detail::poll_group pg(
+        yonaa::detail::socket_status::readable, yonaa::detail::poll_backend::epoll, true);
+    CATCH_REQUIRE(pg.backend() == yonaa::detail::poll_backend::epoll);
+
+    int pair[2];
+    CATCH_REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    pg.add_socket(pair[0]);
+
+    CATCH_REQUIRE(::write(pair[1], "Hello!\n", 7) == 7);
+
+    // A status change is only reported once...
+    CATCH_REQUIRE(pg.poll(1000).size() == 1);
+    CATCH_REQUIRE(pg.poll().empty());
+
+    // ... until the status changes again.
+    CATCH_REQUIRE(::write(pair[1], "Hello!\n", 7) == 7);
+    CATCH_REQUIRE(pg.poll(1000).size() == 1);
+
+    ::close(pair[0]);
+    ::close(pair[1]);
+}
+#endif
@@ -0,0 +1,65 @@
+#include "yonaa/detail/slot_map.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+CATCH_TEST_CASE("[yonaa::detail::slot_map] slot_map", "[net]") {
+    yonaa::detail::slot_map<std::string> sm;
+    CATCH_REQUIRE(sm.empty());
+
+    auto a = sm.insert("a");
+    auto b = sm.insert("b");
+    auto c = sm.emplace(3, 'c');
+
+    CATCH_SECTION("keys find their values") {
+        CATCH_REQUIRE(sm.size() == 3);
+        CATCH_REQUIRE(a != 0);
+        CATCH_REQUIRE(a != b);
+        CATCH_REQUIRE(*sm.find(a) == "a");
+        CATCH_REQUIRE(*sm.find(b) == "b");
+        CATCH_REQUIRE(*sm.find(c) == "ccc");
+        CATCH_REQUIRE(sm.find(0) == nullptr);
+        CATCH_REQUIRE((a >> yonaa::detail::slot_map<std::string>::key_bits) == 0);
+    }
+
+    CATCH_SECTION("erasing a value keeps the others reachable") {
+        CATCH_REQUIRE(sm.erase(a));
+        CATCH_REQUIRE(!sm.erase(a));
+        CATCH_REQUIRE(!sm.contains(a));
+        CATCH_REQUIRE(sm.size() == 2);
+        CATCH_REQUIRE(*sm.find(b) == "b");
+        CATCH_REQUIRE(*sm.find(c) == "ccc");
+
+        // Values are stored contiguously
+        CATCH_REQUIRE(std::distance(sm.begin(), sm.end()) == 2);
+        CATCH_REQUIRE(std::count(sm.begin(), sm.end(), "b") == 1);
+        CATCH_REQUIRE(std::count(sm.begin(), sm.end(), "ccc") == 1);
+    }
+
+    CATCH_SECTION("keys of erased values do not find the values that reuse their slots") {
+        sm.erase(b);
+        auto d = sm.insert("d");
+
+        CATCH_REQUIRE(d != b);
+        CATCH_REQUIRE(sm.find(b) == nullptr);
+        CATCH_REQUIRE(*sm.find(d) == "d");
+    }
+}
+
+CATCH_TEST_CASE("[yonaa::detail::slot_map] slot_map destroys erased values", "[net]") {
+    auto tracker = std::make_shared<int>(0);
+
+    yonaa::detail::slot_map<std::shared_ptr<int>> sm;
+    auto first = sm.insert(tracker);
+    sm.insert(tracker);
+    CATCH_REQUIRE(tracker.use_count() == 3);
+
+    // The erased value is not the last one, so the last value is moved into its place
+    sm.erase(first);
+    CATCH_REQUIRE(tracker.use_count() == 2);
+    CATCH_REQUIRE(sm.size() == 1);
+}
@@ -1,5 +1,14 @@
 #include "yonaa/detail/socket_ops.hpp"
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <vector>
+
 #define CATCH_CONFIG_PREFIX_ALL
 #include <catch2/catch_test_macros.hpp>
 
@@ -15,3 +24,104 @@ CATCH_TEST_CASE("[yonaa::detail::socket_ops] create_listening_socket()") {
 
     CATCH_REQUIRE(socket_fd != 0);
 }
+
+CATCH_TEST_CASE("[yonaa::detail::socket_ops] create_listening_socket() with acceptor_options") {
+    auto rr = yonaa::resolve(yonaa::loopback_address, "5003");
+
+    yonaa::acceptor_options options;
+    options.reuse_port             = true;
+    options.defer_accept           = std::chrono::seconds(5);
+    options.fast_open_queue_length = 16;
+    options.incoming_cpu           = 0;
+
+    socket_type socket_fd = yonaa::detail::socket_ops::create_listening_socket(rr, options);
+    CATCH_REQUIRE(socket_fd != 0);
+
+    // The options should have been applied to the socket...
+    auto get_option = [&](int level, int name) {
+        int value      = 0;
+        socklen_t size = sizeof(value);
+        CATCH_REQUIRE(::getsockopt(socket_fd, level, name, &value, &size) == 0);
+        return value;
+    };
+    CATCH_REQUIRE(get_option(SOL_SOCKET, SO_REUSEADDR) != 0);
+    CATCH_REQUIRE(get_option(SOL_SOCKET, SO_REUSEPORT) != 0);
+    CATCH_REQUIRE(get_option(IPPROTO_TCP, TCP_DEFER_ACCEPT) != 0);
+    CATCH_REQUIRE(get_option(SOL_SOCKET, SO_INCOMING_CPU) == 0);
+
+    // ... and a socket that cannot be bound should be closed rather than leaked.
+    int unused_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::close(unused_fd);
+
+    options.reuse_port = false;
+    CATCH_REQUIRE(yonaa::detail::socket_ops::create_listening_socket(rr, options) == 0);
+
+    int next_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CATCH_REQUIRE(next_fd == unused_fd);
+
+    ::close(next_fd);
+    ::close(socket_fd);
+}
+
+CATCH_TEST_CASE("[yonaa::detail::socket_ops] create_listening_sockets()") {
+    // Both unspecified addresses should be bindable to the same port, and an endpoint that appears
+    // twice should only be bound once
+    auto rr = yonaa::resolve(yonaa::any_address, "5004");
+    rr.push_back(rr.front());
+
+    std::vector<socket_type> socket_fds =
+        yonaa::detail::socket_ops::create_listening_sockets(rr, yonaa::acceptor_options());
+    CATCH_REQUIRE(socket_fds.size() == rr.size() - 1);
+
+    for (socket_type socket_fd : socket_fds) ::close(socket_fd);
+}
+
+CATCH_TEST_CASE("[yonaa::detail::socket_ops] create_connected_socket()") {
+    auto stalled_rr = yonaa::resolve(yonaa::loopback_address, "5007");
+    auto live_rr    = yonaa::resolve(yonaa::loopback_address, "5008");
+
+    // A listener whose backlog is full drops new connection attempts, which then stall
+    yonaa::acceptor_options stalled_options;
+    stalled_options.backlog = 0;
+    socket_type stalled_fd =
+        yonaa::detail::socket_ops::create_listening_socket(stalled_rr, stalled_options);
+    socket_type live_fd =
+        yonaa::detail::socket_ops::create_listening_socket(live_rr, yonaa::acceptor_options());
+    CATCH_REQUIRE(stalled_fd != 0);
+    CATCH_REQUIRE(live_fd != 0);
+
+    socket_type filler_fd = yonaa::detail::socket_ops::create_connected_socket(stalled_rr);
+    CATCH_REQUIRE(filler_fd != 0);
+
+    // A stalled first endpoint should only hold up the next one for the connect delay...
+    yonaa::resolve_result rr = stalled_rr;
+    rr.insert(rr.end(), live_rr.begin(), live_rr.end());
+
+    yonaa::connect_options options;
+    options.connect_delay = std::chrono::milliseconds(50);
+
+    auto start            = std::chrono::steady_clock::now();
+    socket_type socket_fd = yonaa::detail::socket_ops::create_connected_socket(rr, options);
+    auto elapsed          = std::chrono::steady_clock::now() - start;
+
+    CATCH_REQUIRE(socket_fd != 0);
+    CATCH_REQUIRE(elapsed < std::chrono::seconds(1));
+    CATCH_REQUIRE(yonaa::detail::socket_ops::get_remote_endpoint(socket_fd) == live_rr.front());
+    ::close(socket_fd);
+
+    // ... and the sockets of failed attempts should be closed rather than leaked.
+    ::close(live_fd);
+
+    int unused_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::close(unused_fd);
+
+    CATCH_REQUIRE(yonaa::detail::socket_ops::create_connected_socket(live_rr) == 0);
+    CATCH_REQUIRE(errno == ECONNREFUSED);
+
+    int next_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CATCH_REQUIRE(next_fd == unused_fd);
+
+    ::close(next_fd);
+    ::close(filler_fd);
+    ::close(stalled_fd);
+}
@@ -0,0 +1,98 @@
+#include "yonaa/detail/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+CATCH_TEST_CASE("[yonaa::detail::thread_pool] thread_pool", "[net]") {
+    std::atomic<int> count(0);
+
+    CATCH_SECTION("every submitted task runs before the pool is destroyed") {
+        {
+            yonaa::detail::thread_pool pool(4, 16);
+            CATCH_REQUIRE(pool.size() == 4);
+
+            for (int i = 0; i < 1000; i++) {
+                pool.submit([&] { count++; });
+            }
+        }
+
+        CATCH_REQUIRE(count == 1000);
+    }
+
+    CATCH_SECTION("tasks on the same strand run one at a time, in order") {
+        const int strand_count = 8;
+        const int task_count   = 500;
+
+        std::vector<std::shared_ptr<yonaa::detail::strand>> strands;
+        std::vector<std::vector<int>> results(strand_count);
+        std::vector<std::atomic<int>> running(strand_count);
+        std::atomic<bool> overlapped(false);
+
+        {
+            yonaa::detail::thread_pool pool(4, 64);
+            for (int s = 0; s < strand_count; s++) {
+                strands.push_back(std::make_shared<yonaa::detail::strand>());
+            }
+
+            for (int i = 0; i < task_count; i++) {
+                for (int s = 0; s < strand_count; s++) {
+                    pool.submit(strands[s], [&, s, i] {
+                        if (running[s]++ != 0) overlapped = true;
+                        results[s].push_back(i);
+                        running[s]--;
+                    });
+                }
+            }
+        }
+
+        CATCH_REQUIRE(!overlapped);
+        for (const auto &result : results) {
+            CATCH_REQUIRE(result.size() == (size_t)task_count);
+            for (int i = 0; i < task_count; i++) { CATCH_REQUIRE(result[i] == i); }
+        }
+    }
+
+    CATCH_SECTION("submit blocks while the queue is full") {
+        std::mutex gate;
+        std::unique_lock<std::mutex> gate_lock(gate);
+
+        yonaa::detail::thread_pool pool(1, 1);
+
+        // Occupy the only worker, then fill the queue. (The second submit waits for the worker to
+        // start the first task, since a running task no longer counts as queued.)
+        pool.submit([&] { std::lock_guard<std::mutex> lock(gate); });
+        pool.submit([&] { count++; });
+
+        std::atomic<bool> submitted(false);
+        auto submitter = std::thread([&] {
+            pool.submit([&] { count++; });
+            submitted = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CATCH_REQUIRE(!submitted);
+
+        gate_lock.unlock();
+        if (submitter.joinable()) submitter.join();
+        CATCH_REQUIRE(submitted);
+    }
+
+    CATCH_SECTION("workers never block on a full queue") {
+        {
+            yonaa::detail::thread_pool pool(1, 1);
+            pool.submit([&] {
+                for (int i = 0; i < 10; i++) {
+                    pool.submit([&] { count++; });
+                }
+            });
+        }
+
+        CATCH_REQUIRE(count == 10);
+    }
+}
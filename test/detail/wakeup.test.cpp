@@ -0,0 +1,34 @@
+#include "yonaa/detail/wakeup.hpp"
+
+#include <thread>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+#include "yonaa/detail/poll.hpp"
+
+CATCH_TEST_CASE("[yonaa::detail::wakeup] wakeup_event", "[net]") {
+    yonaa::detail::wakeup_event wakeup;
+    yonaa::detail::poll_group pg(yonaa::detail::socket_status::readable);
+    pg.add_socket(wakeup.native_handle());
+
+    // A fresh wakeup event is not readable...
+    CATCH_REQUIRE(pg.poll().empty());
+
+    // ... but becomes readable when notified, no matter how many times...
+    wakeup.notify();
+    wakeup.notify();
+    CATCH_REQUIRE(pg.poll().size() == 1);
+
+    // ... until it is reset.
+    wakeup.reset();
+    CATCH_REQUIRE(pg.poll().empty());
+
+    // Notifications from other threads interrupt a blocking poll
+    auto notifier = std::thread([&] { wakeup.notify(); });
+    auto pr       = pg.poll(-1);
+    CATCH_REQUIRE(pr.size() == 1);
+    CATCH_REQUIRE(pr[0].socket_fd == wakeup.native_handle());
+
+    if (notifier.joinable()) notifier.join();
+}
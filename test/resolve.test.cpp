@@ -2,6 +2,8 @@
 
 #include <netdb.h>
 
+#include <cstring>
+
 #define CATCH_CONFIG_PREFIX_ALL
 #include <catch2/catch_test_macros.hpp>
 
@@ -84,3 +86,27 @@ CATCH_TEST_CASE("[yonaa::resolve] Remote name resolution", "[net]") {
         freeaddrinfo(remote_info);
     }
 }
+
+CATCH_TEST_CASE("[yonaa::resolve] Numeric name resolution", "[net]") {
+    // Numeric addresses and ports should resolve as they would through getaddrinfo()...
+    for (std::string name : {"10.2.3.4", "::1", "::ffff:10.2.3.4", "fe80::1"}) {
+        for (std::string service : {"0", "80", "65535"}) {
+            auto endpoints    = yonaa::resolve(name, service);
+            auto *remote_info = yonaa::detail::gai::getaddrinfo(name, service);
+
+            CATCH_REQUIRE(remote_info);
+            CATCH_REQUIRE(endpoints.size() == 1);
+            CATCH_REQUIRE(endpoints.front().port() == service);
+            CATCH_REQUIRE(endpoints.front().protocol() == remote_info->ai_protocol);
+            CATCH_REQUIRE(rr_ai_compare(endpoints, remote_info));
+
+            freeaddrinfo(remote_info);
+        }
+    }
+
+    // ... while services that are not port numbers should still be handled by it.
+    std::error_code ec;
+    CATCH_REQUIRE(yonaa::resolve(yonaa::loopback_address, "not-a-service", ec).empty());
+    CATCH_REQUIRE(ec);
+    CATCH_REQUIRE(yonaa::resolve(yonaa::loopback_address, "http").front().port() == "80");
+}
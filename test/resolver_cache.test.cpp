@@ -0,0 +1,120 @@
+#include "yonaa/resolver_cache.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+#include "yonaa/addresses.hpp"
+
+CATCH_TEST_CASE("[yonaa::resolver_cache] Results are cached until they expire", "[net]") {
+    yonaa::resolver_cache_config config;
+    config.ttl = std::chrono::milliseconds(100);
+    yonaa::resolver_cache cache(config);
+
+    // The first lookup should miss, and match an uncached resolution...
+    auto endpoints = cache.resolve(yonaa::loopback_address, "5000");
+    CATCH_REQUIRE(endpoints == yonaa::resolve(yonaa::loopback_address, "5000"));
+    CATCH_REQUIRE(cache.misses() == 1);
+    CATCH_REQUIRE(cache.hits() == 0);
+
+    // ... while the next should hit, and return the same result...
+    CATCH_REQUIRE(cache.resolve(yonaa::loopback_address, "5000") == endpoints);
+    CATCH_REQUIRE(cache.misses() == 1);
+    CATCH_REQUIRE(cache.hits() == 1);
+
+    // ... until the result expires.
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    CATCH_REQUIRE(cache.resolve(yonaa::loopback_address, "5000") == endpoints);
+    CATCH_REQUIRE(cache.misses() == 2);
+    CATCH_REQUIRE(cache.size() == 1);
+}
+
+CATCH_TEST_CASE("[yonaa::resolver_cache] Failures are cached too", "[net]") {
+    yonaa::resolver_cache cache;
+    std::error_code ec;
+
+    // A failure should be reported again from the cache...
+    CATCH_REQUIRE(cache.resolve(yonaa::loopback_address, "not-a-service", ec).empty());
+    CATCH_REQUIRE(ec);
+
+    std::error_code cached_ec;
+    CATCH_REQUIRE(cache.resolve(yonaa::loopback_address, "not-a-service", cached_ec).empty());
+    CATCH_REQUIRE(cached_ec == ec);
+    CATCH_REQUIRE(cache.hits() == 1);
+
+    // ... unless negative caching is disabled.
+    yonaa::resolver_cache_config config;
+    config.negative_ttl = std::chrono::milliseconds(0);
+    yonaa::resolver_cache uncached(config);
+
+    uncached.resolve(yonaa::loopback_address, "not-a-service", ec);
+    uncached.resolve(yonaa::loopback_address, "not-a-service", ec);
+    CATCH_REQUIRE(uncached.misses() == 2);
+    CATCH_REQUIRE(uncached.size() == 0);
+}
+
+CATCH_TEST_CASE("[yonaa::resolver_cache] Results can be invalidated", "[net]") {
+    yonaa::resolver_cache cache;
+
+    cache.resolve(yonaa::loopback_address, "5000");
+    cache.resolve(yonaa::loopback_address, "5001");
+    cache.resolve(yonaa::any_address, "5000");
+    CATCH_REQUIRE(cache.size() == 3);
+
+    // Results can be dropped one at a time...
+    cache.invalidate(yonaa::any_address, "5000");
+    CATCH_REQUIRE(cache.size() == 2);
+
+    // ... for every service of a hostname...
+    cache.resolve(yonaa::any_address, "5000");
+    cache.invalidate(yonaa::loopback_address);
+    CATCH_REQUIRE(cache.size() == 1);
+
+    // ... or all at once.
+    cache.clear();
+    CATCH_REQUIRE(cache.size() == 0);
+
+    cache.resolve(yonaa::any_address, "5000");
+    CATCH_REQUIRE(cache.misses() == 5);
+}
+
+CATCH_TEST_CASE("[yonaa::resolver_cache] The cache does not grow past its limit", "[net]") {
+    yonaa::resolver_cache_config config;
+    config.max_entries = 2;
+    yonaa::resolver_cache cache(config);
+
+    for (int port = 5000; port < 5004; port++) {
+        cache.resolve(yonaa::loopback_address, std::to_string(port));
+        CATCH_REQUIRE(cache.size() <= 2);
+    }
+
+    // The most recent result should have been kept
+    cache.resolve(yonaa::loopback_address, "5003");
+    CATCH_REQUIRE(cache.hits() == 1);
+}
+
+CATCH_TEST_CASE("[yonaa::resolver_cache] Lookups can be made from several threads", "[net]") {
+    yonaa::resolver_cache cache;
+    auto expected = yonaa::resolve(yonaa::loopback_address, "5000");
+
+    std::vector<std::thread> threads;
+    std::vector<int> matches(8, 0);
+    for (size_t i = 0; i < matches.size(); i++) {
+        threads.emplace_back([&, i] {
+            bool is_match = true;
+            for (int j = 0; j < 1000; j++) {
+                is_match = is_match && cache.resolve(yonaa::loopback_address, "5000") == expected;
+            }
+            matches[i] = is_match;
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    for (int is_match : matches) CATCH_REQUIRE(is_match);
+    CATCH_REQUIRE(cache.hits() + cache.misses() == 8000);
+    CATCH_REQUIRE(cache.size() == 1);
+}
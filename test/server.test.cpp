@@ -0,0 +1,663 @@
+#include "yonaa/server.hpp"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_PREFIX_ALL
+#include <catch2/catch_test_macros.hpp>
+
+#include "yonaa/addresses.hpp"
+#include "yonaa/detail/poll.hpp"
+#include "yonaa/resolve.hpp"
+
+using namespace std::chrono_literals;
+
+/// @brief The size of each message in a burst, and the number of messages in one. A burst is much
+/// larger than what the kernel buffers for a peer that does not read, so that it overflows a send
+/// queue.
+static const size_t burst_message_size  = 128 * 1024;
+static const size_t burst_message_count = 128;
+
+/// @brief Return a message to be sent in a burst, which is shared by every send.
+static yonaa::shared_buffer make_burst_message() {
+    return yonaa::make_shared_buffer(yonaa::buffer(std::string(burst_message_size, 'x')));
+}
+
+/// @brief Return a server configuration whose send queues fill up well before a burst is queued.
+static yonaa::server_config small_send_queue_config(yonaa::send_queue_overflow_policy policy) {
+    yonaa::server_config config;
+    config.send_queue_limit          = 1024 * 1024;
+    config.send_queue_high_watermark = 512 * 1024;
+    config.send_queue_low_watermark  = 128 * 1024;
+    config.overflow_policy           = policy;
+
+    return config;
+}
+
+/// @brief Connect to a local server, retrying for a while in case it is not listening yet.
+static yonaa::connection connect_peer(const std::string &port) {
+    auto endpoints = yonaa::resolve(yonaa::loopback_address, port);
+    auto deadline  = std::chrono::steady_clock::now() + 5s;
+
+    yonaa::connection peer;
+    std::error_code ec;
+    peer.connect(endpoints, ec);
+    while (ec && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+
+        ec.clear();
+        peer.connect(endpoints, ec);
+    }
+
+    // Note: The receive buffer is fixed, so that the kernel cannot grow it to hold a whole burst
+    // once the peer has read a few.
+    int receive_buffer_size = 64 * 1024;
+    setsockopt(
+        peer.native_socket(),
+        SOL_SOCKET,
+        SO_RCVBUF,
+        &receive_buffer_size,
+        sizeof(receive_buffer_size));
+
+    return peer;
+}
+
+/// @brief Return true if the future becomes ready within the timeout, and false otherwise.
+template<typename T>
+static bool is_ready_within(std::future<T> &future, std::chrono::milliseconds timeout) {
+    return future.wait_for(timeout) == std::future_status::ready;
+}
+
+/// @brief Return whatever data arrives on a connection within the timeout, which is empty if none
+/// arrives in time or if the connection is closed.
+static std::string receive_some(yonaa::connection &conn, int timeout_millis = 5000) {
+    using yonaa::detail::socket_status;
+
+    auto status = yonaa::detail::poll_socket(
+        conn.native_socket(), timeout_millis, socket_status::readable);
+    if (!status) return {};
+
+    std::error_code ec;
+    yonaa::buffer data = conn.receive(64 * 1024, ec);
+    return std::string(data.data(), data.size());
+}
+
+/// @brief Return the index of the reactor that serves a client.
+static size_t reactor_index(yonaa::client_id id) {
+    return id & 0xFF;
+}
+
+CATCH_TEST_CASE(
+    "[yonaa::server] A network thread waiting without a timeout is woken promptly", "[net]") {
+    yonaa::server_config config;
+    config.max_wait = std::chrono::milliseconds(-1);
+    auto server     = std::make_unique<yonaa::server>(5018, config);
+
+    std::promise<yonaa::client_id> connected;
+    std::promise<void> disconnected;
+    server->set_client_connect_handler([&](yonaa::client_id id) { connected.set_value(id); });
+    server->set_client_disconnect_handler([&](yonaa::client_id) { disconnected.set_value(); });
+    server->set_data_receive_handler([](yonaa::client_id, yonaa::buffer_view) {});
+    server->run();
+
+    yonaa::connection peer = connect_peer("5018");
+    yonaa::client_id id    = connected.get_future().get();
+
+    // Let the network thread go back to waiting for network activity
+    std::this_thread::sleep_for(100ms);
+
+    // A message from another thread should be sent right away...
+    server->message_client(yonaa::buffer_view("wake"), id);
+    CATCH_REQUIRE(receive_some(peer, 1000) == "wake");
+
+    // ... and so should a removal...
+    std::this_thread::sleep_for(100ms);
+    server->remove_client(id);
+
+    auto disconnected_future = disconnected.get_future();
+    CATCH_REQUIRE(disconnected_future.wait_for(1s) == std::future_status::ready);
+    CATCH_REQUIRE(receive_some(peer, 1000).empty());
+    CATCH_REQUIRE_FALSE(peer.is_connected());
+
+    // ... and stopping should not wait for network activity either.
+    std::this_thread::sleep_for(100ms);
+
+    auto start = std::chrono::steady_clock::now();
+    server->stop();
+    server.reset();
+
+    CATCH_REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+}
+
+CATCH_TEST_CASE("[yonaa::server] Every poll mechanism serves clients", "[net]") {
+    using yonaa::poll_mechanism;
+
+    auto mechanisms = {poll_mechanism::automatic, poll_mechanism::poll, poll_mechanism::epoll};
+
+    for (auto mechanism : mechanisms) {
+        yonaa::server_config config;
+        config.mechanism = mechanism;
+        yonaa::server server(5021, config);
+
+        server.set_client_connect_handler([](yonaa::client_id) {});
+        server.set_client_disconnect_handler([](yonaa::client_id) {});
+        server.set_data_receive_handler([&](yonaa::client_id id, yonaa::buffer_view data) {
+            server.message_client(data, id);
+        });
+        server.run();
+
+        yonaa::connection peer = connect_peer("5021");
+        peer.send(yonaa::buffer_view("echo"));
+        CATCH_CHECK(receive_some(peer) == "echo");
+
+        peer.disconnect();
+        server.stop();
+    }
+}
+
+CATCH_TEST_CASE("[yonaa::server] Data receive handlers may take a const buffer &", "[net]") {
+    yonaa::server server(5023);
+
+    std::promise<std::string> received;
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler([&](yonaa::client_id, const yonaa::buffer &data) {
+        received.set_value(data.str());
+    });
+    server.run();
+
+    yonaa::connection peer = connect_peer("5023");
+    peer.send(yonaa::buffer_view("hello"));
+
+    auto received_future = received.get_future();
+    CATCH_REQUIRE(is_ready_within(received_future, 5s));
+    CATCH_REQUIRE(received_future.get() == "hello");
+
+    peer.disconnect();
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::server] Clients are served by the reactor that their id names", "[net]") {
+    const size_t peer_count = 32;
+
+    yonaa::server_config config;
+    config.reactor_count = 4;
+    yonaa::server server(5016, config);
+
+    // Every handler records the thread that it was called on for the client's reactor, and each
+    // peer introduces itself by sending its index
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<size_t, std::thread::id> threads_by_reactor;
+    std::map<std::string, yonaa::client_id> ids_by_peer;
+    std::set<yonaa::client_id> disconnected_ids;
+    bool is_thread_consistent = true;
+
+    auto record_thread = [&](yonaa::client_id id) {
+        std::thread::id thread = std::this_thread::get_id();
+        auto [it, is_new]      = threads_by_reactor.emplace(reactor_index(id), thread);
+        if (!is_new && it->second != thread) is_thread_consistent = false;
+    };
+
+    server.set_client_connect_handler([&](yonaa::client_id id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        record_thread(id);
+    });
+    server.set_client_disconnect_handler([&](yonaa::client_id id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        record_thread(id);
+        disconnected_ids.insert(id);
+        changed.notify_all();
+    });
+    server.set_data_receive_handler([&](yonaa::client_id id, yonaa::buffer_view data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        record_thread(id);
+        ids_by_peer[std::string(data.data(), data.size())] = id;
+        changed.notify_all();
+    });
+    server.run();
+
+    std::vector<yonaa::connection> peers;
+    for (size_t i = 0; i < peer_count; i++) {
+        peers.push_back(connect_peer("5016"));
+        peers.back().send(yonaa::buffer_view(std::to_string(i)));
+    }
+
+    std::vector<yonaa::client_id> ids;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        CATCH_REQUIRE(
+            changed.wait_for(lock, 5s, [&]() { return ids_by_peer.size() == peer_count; }));
+
+        for (size_t i = 0; i < peer_count; i++) ids.push_back(ids_by_peer.at(std::to_string(i)));
+    }
+
+    // Every id should name one of the reactors, and the connections should be spread across them
+    std::set<size_t> reactor_indices;
+    for (yonaa::client_id id : ids) {
+        CATCH_REQUIRE(reactor_index(id) < config.reactor_count);
+        reactor_indices.insert(reactor_index(id));
+    }
+    CATCH_REQUIRE(reactor_indices.size() > 1);
+
+    // Messages sent from this thread should reach the right client...
+    for (size_t i = 0; i < peer_count; i++) {
+        server.message_client(yonaa::buffer_view("to " + std::to_string(i)), ids[i]);
+    }
+    for (size_t i = 0; i < peer_count; i++) {
+        CATCH_REQUIRE(receive_some(peers[i]) == "to " + std::to_string(i));
+    }
+
+    // ... and so should removals
+    std::set<yonaa::client_id> removed_ids;
+    for (size_t i = 0; i < peer_count; i += 2) {
+        server.remove_client(ids[i]);
+        removed_ids.insert(ids[i]);
+    }
+
+    for (size_t i = 0; i < peer_count; i++) {
+        if (i % 2 == 0) {
+            CATCH_REQUIRE(receive_some(peers[i]).empty());
+            CATCH_REQUIRE_FALSE(peers[i].is_connected());
+        } else {
+            CATCH_REQUIRE(peers[i].is_connected());
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        CATCH_REQUIRE(changed.wait_for(
+            lock, 5s, [&]() { return disconnected_ids.size() == removed_ids.size(); }));
+
+        CATCH_REQUIRE(disconnected_ids == removed_ids);
+        CATCH_REQUIRE(is_thread_consistent);
+
+        std::set<std::thread::id> threads;
+        for (const auto &[index, thread] : threads_by_reactor) threads.insert(thread);
+        CATCH_REQUIRE(threads.size() == threads_by_reactor.size());
+    }
+
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::server] Handler threads keep each client's calls in order", "[net]") {
+    const size_t message_count = 2000;
+
+    yonaa::server_config config;
+    config.handler_thread_count = 4;
+    yonaa::server server(5019, config);
+
+    // A client that sends "wait" holds up a handler thread until it is released, one that sends
+    // "ping" is answered, and everything else that arrives is recorded in order
+    std::promise<void> waiting, released;
+    std::shared_future<void> is_released = released.get_future().share();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::string recorded;
+
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler([&](yonaa::client_id id, yonaa::buffer_view data) {
+        std::string text(data.data(), data.size());
+        if (text == "wait") {
+            waiting.set_value();
+            is_released.wait();
+        } else if (text == "ping") {
+            server.message_client(yonaa::buffer_view("pong"), id);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex);
+            recorded += text;
+            changed.notify_all();
+        }
+    });
+    server.run();
+
+    yonaa::connection slow_peer = connect_peer("5019");
+    yonaa::connection fast_peer = connect_peer("5019");
+
+    // A slow handler should not hold up the other clients...
+    slow_peer.send(yonaa::buffer_view("wait"));
+    CATCH_REQUIRE(waiting.get_future().wait_for(5s) == std::future_status::ready);
+
+    fast_peer.send(yonaa::buffer_view("ping"));
+    std::string answer = receive_some(fast_peer, 1000);
+    released.set_value();
+
+    CATCH_REQUIRE(answer == "pong");
+
+    // ... and a client's data should be handled in the order that it arrived, even though it is
+    // spread across several handler threads.
+    std::string expected;
+    for (size_t i = 0; i < message_count; i++) {
+        std::string message = std::to_string(i) + ";";
+        slow_peer.send(yonaa::buffer_view(message));
+        expected += message;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, 5s, [&]() { return recorded.size() >= expected.size(); });
+        CATCH_REQUIRE(recorded == expected);
+    }
+
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::server] Ids of removed clients are not reused", "[net]") {
+    yonaa::server server(5020);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<yonaa::client_id> connected_ids;
+    std::map<yonaa::client_id, int> disconnect_counts;
+
+    server.set_client_connect_handler([&](yonaa::client_id id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected_ids.push_back(id);
+        changed.notify_all();
+    });
+    server.set_client_disconnect_handler([&](yonaa::client_id id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        disconnect_counts[id]++;
+        changed.notify_all();
+    });
+    server.set_data_receive_handler([](yonaa::client_id, yonaa::buffer_view) {});
+    server.run();
+
+    auto wait_for = [&](auto condition) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, 5s, condition);
+    };
+
+    // The first client hangs up, which frees its slot (and likely its descriptor)...
+    yonaa::connection first_peer = connect_peer("5020");
+    CATCH_REQUIRE(wait_for([&]() { return connected_ids.size() == 1; }));
+    first_peer.disconnect();
+    CATCH_REQUIRE(wait_for([&]() { return disconnect_counts.size() == 1; }));
+
+    // ... so the next client takes it over, under an id of its own...
+    yonaa::connection second_peer = connect_peer("5020");
+    CATCH_REQUIRE(wait_for([&]() { return connected_ids.size() == 2; }));
+
+    yonaa::client_id first_id  = connected_ids[0];
+    yonaa::client_id second_id = connected_ids[1];
+    CATCH_REQUIRE(first_id != second_id);
+
+    // ... that calls made with the old id do not reach.
+    server.remove_client(first_id);
+    server.message_client(yonaa::buffer_view("stale"), first_id);
+    server.message_client(yonaa::buffer_view("fresh"), second_id);
+
+    CATCH_REQUIRE(receive_some(second_peer) == "fresh");
+    CATCH_REQUIRE(second_peer.is_connected());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CATCH_REQUIRE(disconnect_counts[first_id] == 1);
+        CATCH_REQUIRE(disconnect_counts.count(second_id) == 0);
+    }
+
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::server] Views sent from a network thread may be reused at once", "[net]") {
+    // A message much larger than what the kernel buffers for a peer, so that some of it is sent
+    // straight from the view and the rest has to be queued
+    std::string expected_body(1024 * 1024, '\0');
+    for (size_t i = 0; i < expected_body.size(); i++) expected_body[i] = (char)(i % 251);
+
+    // The server answers any message with a header and the body, and sends the body to every
+    // client, and then overwrites the body before returning
+    yonaa::server server(5022);
+
+    std::atomic<size_t> connected_count{0};
+    server.set_client_connect_handler([&](yonaa::client_id) { connected_count++; });
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler([&](yonaa::client_id id, yonaa::buffer_view) {
+        std::string body = expected_body;
+        server.message_client(yonaa::buffer_sequence{yonaa::buffer_view("head"), body}, id);
+        server.message_all_clients(yonaa::buffer_view(body));
+
+        std::fill(body.begin(), body.end(), 'x');
+    });
+    server.run();
+
+    yonaa::connection first_peer  = connect_peer("5022");
+    yonaa::connection second_peer = connect_peer("5022");
+
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (connected_count < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    CATCH_REQUIRE(connected_count == 2);
+
+    auto receive_all = [](yonaa::connection &peer, size_t size) {
+        std::string received;
+        while (received.size() < size) {
+            std::string data = receive_some(peer);
+            if (data.empty()) break;
+            received += data;
+        }
+
+        return received;
+    };
+
+    first_peer.send(yonaa::buffer_view("go"));
+
+    std::string first_received = receive_all(first_peer, 4 + 2 * expected_body.size());
+    CATCH_REQUIRE(first_received == "head" + expected_body + expected_body);
+
+    std::string second_received = receive_all(second_peer, expected_body.size());
+    CATCH_REQUIRE(second_received == expected_body);
+
+    first_peer.disconnect();
+    second_peer.disconnect();
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::server] Send queue watermarks are reported once per crossing", "[net]") {
+    // The server answers 'b' with a burst of messages that its send queue cannot hold, and 'p'
+    // with "pong"
+    yonaa::server server(5013, small_send_queue_config(yonaa::send_queue_overflow_policy::drop));
+    auto burst = make_burst_message();
+
+    std::atomic<int> high_count{0}, low_count{0};
+    server.set_send_queue_high_watermark_handler([&](yonaa::client_id, size_t) { high_count++; });
+    server.set_send_queue_low_watermark_handler([&](yonaa::client_id, size_t) { low_count++; });
+    server.set_client_connect_handler([](yonaa::client_id) {});
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler([&](yonaa::client_id id, yonaa::buffer_view data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            if (data.data()[i] == 'b') {
+                for (size_t j = 0; j < burst_message_count; j++) server.message_client(burst, id);
+            } else if (data.data()[i] == 'p') {
+                server.message_client(yonaa::buffer_view("pong"), id);
+            }
+        }
+    });
+    server.run();
+
+    yonaa::connection peer = connect_peer("5013");
+
+    for (int round = 1; round <= 2; round++) {
+        // Overflowing the queue should report the high watermark once, and drop the rest...
+        peer.send(yonaa::buffer_view("b"));
+
+        size_t received = 0;
+        while (low_count < round) {
+            std::string data = receive_some(peer);
+            if (data.empty()) break;
+            received += data.size();
+        }
+
+        // ... and draining it should report the low watermark once, and leave the client
+        // connected.
+        peer.send(yonaa::buffer_view("p"));
+
+        std::string tail;
+        while (tail.size() < 4 || tail.compare(tail.size() - 4, 4, "pong") != 0) {
+            std::string data = receive_some(peer);
+            if (data.empty()) break;
+            received += data.size();
+
+            tail += data;
+            if (tail.size() > 4) tail.erase(0, tail.size() - 4);
+        }
+
+        CATCH_REQUIRE(tail == "pong");
+        CATCH_REQUIRE(high_count == round);
+        CATCH_REQUIRE(low_count == round);
+        CATCH_REQUIRE(received - 4 < burst_message_size * burst_message_count);
+    }
+
+    server.stop();
+}
+
+CATCH_TEST_CASE(
+    "[yonaa::server] Clients that overflow their send queue are disconnected", "[net]") {
+    yonaa::server server(
+        5014, small_send_queue_config(yonaa::send_queue_overflow_policy::disconnect));
+    auto burst = make_burst_message();
+
+    std::promise<void> disconnected;
+    server.set_client_connect_handler([&](yonaa::client_id id) {
+        for (size_t i = 0; i < burst_message_count; i++) server.message_client(burst, id);
+    });
+    server.set_client_disconnect_handler([&](yonaa::client_id) { disconnected.set_value(); });
+    server.set_data_receive_handler([](yonaa::client_id, yonaa::buffer_view) {});
+    server.run();
+
+    yonaa::connection peer = connect_peer("5014");
+
+    // The server should give up on the client rather than queue the whole burst...
+    auto disconnected_future = disconnected.get_future();
+    CATCH_REQUIRE(is_ready_within(disconnected_future, 5s));
+
+    // ... so that the client sees the connection close before all of it arrives.
+    size_t received = 0;
+    while (true) {
+        std::string data = receive_some(peer);
+        if (data.empty()) break;
+        received += data.size();
+    }
+
+    CATCH_REQUIRE_FALSE(peer.is_connected());
+    CATCH_REQUIRE(received < burst_message_size * burst_message_count);
+
+    server.stop();
+}
+
+CATCH_TEST_CASE("[yonaa::server] Blocked messages wait for room in the send queue", "[net]") {
+    yonaa::server server(5015, small_send_queue_config(yonaa::send_queue_overflow_policy::block));
+    auto burst = make_burst_message();
+
+    std::promise<yonaa::client_id> connected;
+    std::promise<void> disconnected;
+    server.set_client_connect_handler([&](yonaa::client_id id) { connected.set_value(id); });
+    server.set_client_disconnect_handler([&](yonaa::client_id) { disconnected.set_value(); });
+    server.set_data_receive_handler([](yonaa::client_id, yonaa::buffer_view) {});
+    server.run();
+
+    yonaa::connection peer = connect_peer("5015");
+    yonaa::client_id id    = connected.get_future().get();
+
+    // Sends from another thread wait for room in the queue, rather than dropping anything...
+    auto send_burst = [&]() {
+        for (size_t i = 0; i < burst_message_count; i++) server.message_client(burst, id);
+    };
+
+    auto first_burst = std::async(std::launch::async, send_burst);
+
+    size_t received = 0;
+    while (received < burst_message_size * burst_message_count) {
+        std::string data = receive_some(peer);
+        if (data.empty()) break;
+        received += data.size();
+    }
+
+    CATCH_REQUIRE(received == burst_message_size * burst_message_count);
+    CATCH_REQUIRE(is_ready_within(first_burst, 5s));
+
+    // ... and are released when the client disconnects while they are waiting.
+    // Note: The peer disconnects before anything is checked, so that a failure cannot leave the
+    // burst blocked forever.
+    auto second_burst = std::async(std::launch::async, send_burst);
+    bool is_second_burst_blocked = !is_ready_within(second_burst, 200ms);
+
+    peer.disconnect();
+
+    auto disconnected_future = disconnected.get_future();
+    CATCH_REQUIRE(is_second_burst_blocked);
+    CATCH_REQUIRE(is_ready_within(disconnected_future, 5s));
+    CATCH_REQUIRE(is_ready_within(second_burst, 5s));
+
+    server.stop();
+}
+
+CATCH_TEST_CASE(
+    "[yonaa::server] Messages to all clients share one payload across reactors", "[net]") {
+    const size_t peer_count = 4;
+
+    // The payload is much larger than what the kernel buffers for a peer that does not read, so
+    // most of it waits in the send queues
+    const size_t payload_size = burst_message_size * burst_message_count;
+
+    yonaa::server_config config;
+    config.reactor_count = 4;
+    yonaa::server server(5017, config);
+
+    std::atomic<size_t> connected_count{0};
+    server.set_client_connect_handler([&](yonaa::client_id) { connected_count++; });
+    server.set_client_disconnect_handler([](yonaa::client_id) {});
+    server.set_data_receive_handler([](yonaa::client_id, yonaa::buffer_view) {});
+    server.run();
+
+    std::vector<yonaa::connection> peers;
+    for (size_t i = 0; i < peer_count; i++) peers.push_back(connect_peer("5017"));
+
+    auto wait_until = [](auto condition) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(1ms);
+        }
+
+        return condition();
+    };
+
+    CATCH_REQUIRE(wait_until([&]() { return connected_count == peer_count; }));
+
+    // Every send queue should refer to the payload, rather than to a copy of it...
+    auto payload = yonaa::make_shared_buffer(yonaa::buffer(std::string(payload_size, 'x')));
+    server.message_all_clients(payload);
+
+    CATCH_REQUIRE(wait_until([&]() { return (size_t)payload.use_count() == 1 + peer_count; }));
+
+    // ... until every client has received all of it
+    for (auto &peer : peers) {
+        size_t received = 0;
+        while (received < payload_size) {
+            std::string data = receive_some(peer);
+            if (data.empty()) break;
+            received += data.size();
+        }
+
+        CATCH_REQUIRE(received == payload_size);
+    }
+
+    CATCH_REQUIRE(wait_until([&]() { return payload.use_count() == 1; }));
+
+    server.stop();
+}